@@ -1,7 +1,18 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include "ecat_slv.h"
+#include "esc_hw.h"
+#include "esc_irq.h"
 #include "utypes.h"
 
+#ifndef ESC_DEVICE
+#define ESC_DEVICE "/dev/lan9252"
+#endif
+
+#define ISR_PRIORITY    80
+#define WORKER_PRIORITY 40
+
 /* Application variables */
 _Objects    Obj;
 
@@ -15,12 +26,16 @@ void cb_set_outputs (void)
 
 int main_run (void * arg)
 {
+   const esc_irq_cfg_t * irq = arg;
    static esc_cfg_t config =
    {
-      .user_arg = "/dev/lan9252",
+      .user_arg = ESC_DEVICE,
       .use_interrupt = 0,
       .watchdog_cnt = 150,
       .set_defaults_hook = NULL,
+      .default_image = &ObjDefaults,
+      .default_store = &Obj,
+      .default_size = sizeof (Obj),
       .pre_state_change_hook = NULL,
       .post_state_change_hook = NULL,
       .application_hook = NULL,
@@ -36,8 +51,27 @@ int main_run (void * arg)
    };
 
    printf ("Hello Main\n");
+   if (irq != NULL)
+   {
+      config.use_interrupt = 1;
+      config.esc_hw_interrupt_enable = ESC_interrupt_enable;
+      config.esc_hw_interrupt_disable = ESC_interrupt_disable;
+   }
    ecat_slv_init (&config);
 
+   if (irq != NULL)
+   {
+      if (ESC_irq_start (irq) != 0)
+      {
+         printf ("Failed to start interrupt handling\n");
+         return 1;
+      }
+      while (1)
+      {
+         pause();
+      }
+   }
+
    while (1)
    {
       ecat_slv();
@@ -46,9 +80,49 @@ int main_run (void * arg)
    return 0;
 }
 
-int main (void)
+static void usage (const char * name)
 {
+   printf ("Usage: %s [-g gpiochip -l line | -u uio]\n", name);
+   printf ("  -g gpiochip   gpiochip with the LAN9252 IRQ line\n");
+   printf ("  -l line       line offset of the LAN9252 IRQ on the gpiochip\n");
+   printf ("  -u uio        UIO device owning the LAN9252 IRQ\n");
+   printf ("Polls the ESC if no interrupt source is given.\n");
+}
+
+int main (int argc, char * argv[])
+{
+   esc_irq_cfg_t irq =
+   {
+      .source = ESC_IRQ_GPIO,
+      .device = NULL,
+      .line = 0,
+      .fd = -1,
+      .isr_priority = ISR_PRIORITY,
+      .worker_priority = WORKER_PRIORITY,
+   };
+   int opt;
+
+   while ((opt = getopt (argc, argv, "g:l:u:h")) != -1)
+   {
+      switch (opt)
+      {
+         case 'g':
+            irq.source = ESC_IRQ_GPIO;
+            irq.device = optarg;
+            break;
+         case 'l':
+            irq.line = (unsigned int)strtoul (optarg, NULL, 0);
+            break;
+         case 'u':
+            irq.source = ESC_IRQ_UIO;
+            irq.device = optarg;
+            break;
+         default:
+            usage (argv[0]);
+            return 1;
+      }
+   }
+
    printf ("Hello Main\n");
-   main_run (NULL);
-   return 0;
+   return main_run ((irq.device != NULL) ? &irq : NULL);
 }
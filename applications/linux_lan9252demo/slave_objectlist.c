@@ -21,33 +21,19 @@ static const char acName1018_02[] = "Product Code";
 static const char acName1018_03[] = "Revision Number";
 static const char acName1018_04[] = "Serial Number";
 static const char acName1600[] = "LEDs";
-static const char acName1600_00[] = "Max SubIndex";
 static const char acName1600_01[] = "LED0";
 static const char acName1600_02[] = "LED1";
 static const char acName1A00[] = "Buttons";
-static const char acName1A00_00[] = "Max SubIndex";
 static const char acName1A00_01[] = "Button1";
 static const char acName1C00[] = "Sync Manager Communication Type";
-static const char acName1C00_00[] = "Max SubIndex";
 static const char acName1C00_01[] = "Communications Type SM0";
 static const char acName1C00_02[] = "Communications Type SM1";
 static const char acName1C00_03[] = "Communications Type SM2";
 static const char acName1C00_04[] = "Communications Type SM3";
 static const char acName1C12[] = "Sync Manager 2 PDO Assignment";
-static const char acName1C12_00[] = "Max SubIndex";
 static const char acName1C12_01[] = "PDO Mapping";
 static const char acName1C13[] = "Sync Manager 3 PDO Assignment";
-static const char acName1C13_00[] = "Max SubIndex";
-static const char acName1C13_01[] = "PDO Mapping";
-static const char acName6000[] = "Buttons";
-static const char acName6000_00[] = "Max SubIndex";
-static const char acName6000_01[] = "Button1";
-static const char acName7000[] = "LEDs";
-static const char acName7000_00[] = "Max SubIndex";
-static const char acName7000_01[] = "LED0";
-static const char acName7000_02[] = "LED1";
 static const char acName8000[] = "Parameters";
-static const char acName8000_00[] = "Max SubIndex";
 static const char acName8000_01[] = "Multiplier";
 
 const _objd SDO1000[] =
@@ -60,11 +46,11 @@ const _objd SDO1008[] =
 };
 const _objd SDO1009[] =
 {
-  {0x0, DTYPE_VISIBLE_STRING, 0, ATYPE_RO, acName1009, 0, HW_REV},
+  {0x0, DTYPE_VISIBLE_STRING, 8 * (sizeof (HW_REV) - 1), ATYPE_RO, acName1009, 0, HW_REV},
 };
 const _objd SDO100A[] =
 {
-  {0x0, DTYPE_VISIBLE_STRING, 0, ATYPE_RO, acName100A, 0, SW_REV},
+  {0x0, DTYPE_VISIBLE_STRING, 8 * (sizeof (SW_REV) - 1), ATYPE_RO, acName100A, 0, SW_REV},
 };
 const _objd SDO1018[] =
 {
@@ -76,18 +62,18 @@ const _objd SDO1018[] =
 };
 const _objd SDO1600[] =
 {
-  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1600_00, 2, NULL},
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1018_00, 2, NULL},
   {0x01, DTYPE_UNSIGNED32, 32, ATYPE_RO, acName1600_01, 0x70000108, NULL},
   {0x02, DTYPE_UNSIGNED32, 32, ATYPE_RO, acName1600_02, 0x70000208, NULL},
 };
 const _objd SDO1A00[] =
 {
-  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1A00_00, 1, NULL},
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1018_00, 1, NULL},
   {0x01, DTYPE_UNSIGNED32, 32, ATYPE_RO, acName1A00_01, 0x60000108, NULL},
 };
 const _objd SDO1C00[] =
 {
-  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1C00_00, 4, NULL},
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1018_00, 4, NULL},
   {0x01, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1C00_01, 1, NULL},
   {0x02, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1C00_02, 2, NULL},
   {0x03, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1C00_03, 3, NULL},
@@ -95,28 +81,28 @@ const _objd SDO1C00[] =
 };
 const _objd SDO1C12[] =
 {
-  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1C12_00, 1, NULL},
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1018_00, 1, NULL},
   {0x01, DTYPE_UNSIGNED16, 16, ATYPE_RO, acName1C12_01, 0x1600, NULL},
 };
 const _objd SDO1C13[] =
 {
-  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1C13_00, 1, NULL},
-  {0x01, DTYPE_UNSIGNED16, 16, ATYPE_RO, acName1C13_01, 0x1A00, NULL},
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1018_00, 1, NULL},
+  {0x01, DTYPE_UNSIGNED16, 16, ATYPE_RO, acName1C12_01, 0x1A00, NULL},
 };
 const _objd SDO6000[] =
 {
-  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName6000_00, 1, NULL},
-  {0x01, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName6000_01, 0, &Obj.Buttons.Button1},
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1018_00, 1, NULL},
+  {0x01, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1A00_01, 0, &Obj.Buttons.Button1},
 };
 const _objd SDO7000[] =
 {
-  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName7000_00, 2, NULL},
-  {0x01, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName7000_01, 0, &Obj.LEDs.LED0},
-  {0x02, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName7000_02, 0, &Obj.LEDs.LED1},
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1018_00, 2, NULL},
+  {0x01, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1600_01, 0, &Obj.LEDs.LED0},
+  {0x02, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1600_02, 0, &Obj.LEDs.LED1},
 };
 const _objd SDO8000[] =
 {
-  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName8000_00, 1, NULL},
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1018_00, 1, NULL},
   {0x01, DTYPE_UNSIGNED32, 32, ATYPE_RW, acName8000_01, 0, &Obj.Parameters.Multiplier},
 };
 
@@ -132,8 +118,25 @@ const _objectlist SDOobjects[] =
   {0x1C00, OTYPE_ARRAY, 4, 0, acName1C00, SDO1C00},
   {0x1C12, OTYPE_ARRAY, 1, 0, acName1C12, SDO1C12},
   {0x1C13, OTYPE_ARRAY, 1, 0, acName1C13, SDO1C13},
-  {0x6000, OTYPE_RECORD, 1, 0, acName6000, SDO6000},
-  {0x7000, OTYPE_RECORD, 2, 0, acName7000, SDO7000},
+  {0x6000, OTYPE_RECORD, 1, 0, acName1A00, SDO6000},
+  {0x7000, OTYPE_RECORD, 2, 0, acName1600, SDO7000},
   {0x8000, OTYPE_RECORD, 1, 0, acName8000, SDO8000},
   {0xffff, 0xff, 0xff, 0xff, NULL, NULL}
 };
+
+const _Objects ObjDefaults =
+{
+   .Buttons =
+   {
+      .Button1 = 0,
+   },
+   .LEDs =
+   {
+      .LED0 = 0,
+      .LED1 = 0,
+   },
+   .Parameters =
+   {
+      .Multiplier = 0,
+   },
+};
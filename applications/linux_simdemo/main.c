@@ -0,0 +1,398 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include "ecat_slv.h"
+#include "esc_hw.h"
+#include "esc_irq.h"
+#include "esc_stats.h"
+#include "utypes.h"
+
+/* Process data sizes given by the PDO mappings in slave_objectlist.c */
+#define RXPDO_BYTES     2
+#define TXPDO_BYTES     1
+#define STATE_TIMEOUT   1000
+#define CYCLE_TIMEOUT   1000000
+#define SM_STATUS_MBXFULL 0x08
+
+/* Application variables */
+_Objects    Obj;
+
+/* Stack run by the interrupt threads instead of ecat_slv() */
+static int use_irq;
+
+void cb_get_inputs (void)
+{
+   Obj.Buttons.Button1 = (uint8_t)(Obj.LEDs.LED0 ^ Obj.LEDs.LED1);
+}
+
+void cb_set_outputs (void)
+{
+}
+
+/* Configure a SyncManager the way the master does */
+static void master_sm_config (uint8_t n, uint16_t psa, uint16_t length,
+                              uint8_t control)
+{
+   uint8_t sm[7];
+
+   sm[0] = (uint8_t)(psa & 0xFF);
+   sm[1] = (uint8_t)(psa >> 8);
+   sm[2] = (uint8_t)(length & 0xFF);
+   sm[3] = (uint8_t)(length >> 8);
+   sm[4] = control;
+   sm[5] = 0;
+   sm[6] = (length > 0) ? ESCREG_SMENABLE_BIT : 0;
+   ESC_sim_ecat_write ((uint16_t)(ESCREG_SM0 + (n << 3)), sm, sizeof (sm));
+}
+
+/* Request a state and run the stack until the slave has reached it */
+static int master_request_state (uint8_t state)
+{
+   uint16_t alcontrol = htoes (state);
+   uint16_t alstatus = 0;
+   int i;
+
+   ESC_sim_ecat_write (ESCREG_ALCONTROL, &alcontrol, sizeof (alcontrol));
+   for (i = 0; i < STATE_TIMEOUT; i++)
+   {
+      if (use_irq)
+      {
+         usleep (1000);
+      }
+      else
+      {
+         ecat_slv();
+      }
+      ESC_sim_ecat_read (ESCREG_ALSTATUS, &alstatus, sizeof (alstatus));
+      if ((etohs (alstatus) & ESCREG_AL_STATEMASK) == state)
+      {
+         return 0;
+      }
+   }
+   printf ("Failed to reach state 0x%x, AL status 0x%x\n", state,
+           etohs (alstatus));
+   return -1;
+}
+
+static uint64_t time_ns (void)
+{
+   struct timespec ts;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t get_timestamp (void)
+{
+   return (uint32_t)time_ns();
+}
+
+#if USE_STATS
+/* Records fetched from the stats ring buffer */
+static unsigned long stats_records;
+
+/* Drain the stats ring buffer, as an application logging them would */
+static void drain_stats (void)
+{
+   esc_stats_record_t records[64];
+   unsigned int n;
+
+   do
+   {
+      n = ESC_stats_read (records, 64);
+      stats_records += n;
+   } while (n == 64);
+}
+
+/* Upload a 32-bit sub-index with an expedited SDO upload, the way the
+ * master does
+ */
+static int master_sdo_upload32 (uint16_t index, uint8_t subindex,
+                                uint32_t * value)
+{
+   static uint8_t cnt;
+   uint8_t mbx[MBXSIZE] = { 0 };
+   uint8_t status = 0;
+   long i;
+
+   cnt = (uint8_t)((cnt % 7) + 1);
+   mbx[0] = 10;
+   mbx[5] = (uint8_t)(MBXCOE | (cnt << 4));
+   mbx[7] = (uint8_t)(COE_SDOREQUEST << 4);
+   mbx[8] = 0x40;
+   mbx[9] = (uint8_t)(index & 0xFF);
+   mbx[10] = (uint8_t)(index >> 8);
+   mbx[11] = subindex;
+   ESC_sim_ecat_write (MBX0_sma, mbx, MBX0_sml);
+
+   for (i = 0; i < CYCLE_TIMEOUT; i++)
+   {
+      if (use_irq)
+      {
+         sched_yield();
+      }
+      else
+      {
+         ecat_slv();
+      }
+      ESC_sim_ecat_read (ESCREG_SM1 + 5, &status, sizeof (status));
+      if (status & SM_STATUS_MBXFULL)
+      {
+         break;
+      }
+   }
+   if ((status & SM_STATUS_MBXFULL) == 0)
+   {
+      return -1;
+   }
+   ESC_sim_ecat_read (MBX1_sma, mbx, MBX1_sml);
+   if (((mbx[7] >> 4) != COE_SDORESPONSE) || ((mbx[8] & 0xE2) != 0x42))
+   {
+      return -1;
+   }
+   *value = (uint32_t)mbx[12] | ((uint32_t)mbx[13] << 8) |
+      ((uint32_t)mbx[14] << 16) | ((uint32_t)mbx[15] << 24);
+   return 0;
+}
+
+static void print_latency (const char * name,
+                           const esc_stats_latency_t * latency)
+{
+   printf ("%-18s count %u, min %u ns, max %u ns\n", name, latency->count,
+           latency->min, latency->max);
+}
+
+static void print_stats (void)
+{
+   esc_stats_t stats;
+
+   uint32_t calc_copy;
+
+   ESC_stats_get (&stats);
+   /* The simulator has no SYNC0 source */
+   if (stats.sync0_to_outputs.count > 0)
+   {
+      print_latency ("SYNC0 to outputs", &stats.sync0_to_outputs);
+   }
+   print_latency ("SM2 to inputs", &stats.sm2_to_inputs);
+   print_latency ("Outputs copy", &stats.outputs_copy);
+   print_latency ("Inputs copy", &stats.inputs_copy);
+   print_latency ("Mailbox process", &stats.mbxprocess);
+   printf ("cycle min %u ns, max %u ns, SM event missed %u, "
+           "cycle too small %u, ring overruns %u\n", stats.min_cycle,
+           stats.max_cycle, stats.sm_event_missed, stats.cycle_too_small,
+           stats.overruns);
+   printf ("%lu records read from the ring buffer\n", stats_records);
+   if (master_sdo_upload32 (0x1C32, 0x06, &calc_copy) == 0)
+   {
+      printf ("0x1C32:06 Calc and Copy Time %u ns\n", calc_copy);
+   }
+   if (master_sdo_upload32 (0x1C33, 0x06, &calc_copy) == 0)
+   {
+      printf ("0x1C33:06 Calc and Copy Time %u ns\n", calc_copy);
+   }
+}
+#endif
+
+/* Wait for the interrupt threads to produce the expected inputs */
+static int wait_inputs (uint8_t expected, uint8_t * inputs)
+{
+   long i;
+
+   for (i = 0; i < CYCLE_TIMEOUT; i++)
+   {
+      ESC_sim_ecat_read (SM3_sma, inputs, TXPDO_BYTES);
+      if (inputs[0] == expected)
+      {
+         return 0;
+      }
+      sched_yield();
+   }
+   return -1;
+}
+
+#if USE_TRIPLE_BUFFER
+/* Application cycle, run in a context of its own when the process data is
+ * triple buffered. Makes the inputs from the outputs of the last cycle,
+ * once the stack has published them.
+ */
+static int app_cycle (void)
+{
+   long i;
+
+   for (i = 0; i < CYCLE_TIMEOUT; i++)
+   {
+      if (ecat_slv_read_outputs() != 0)
+      {
+         cb_set_outputs();
+         cb_get_inputs();
+         ecat_slv_write_inputs();
+         return 0;
+      }
+      sched_yield();
+   }
+   return -1;
+}
+#endif
+
+int main_run (void * arg)
+{
+   static esc_cfg_t config =
+   {
+      .user_arg = NULL,
+      .use_interrupt = 0,
+      .watchdog_cnt = 150,
+      .set_defaults_hook = NULL,
+      .default_image = &ObjDefaults,
+      .default_store = &Obj,
+      .default_size = sizeof (Obj),
+      .pre_state_change_hook = NULL,
+      .post_state_change_hook = NULL,
+      .application_hook = NULL,
+      .safeoutput_override = NULL,
+      .pre_object_download_hook = NULL,
+      .post_object_download_hook = NULL,
+      .rxpdo_override = NULL,
+      .txpdo_override = NULL,
+      .esc_hw_interrupt_enable = NULL,
+      .esc_hw_interrupt_disable = NULL,
+      .esc_hw_eep_handler = NULL,
+      .esc_check_dc_handler = NULL,
+      .get_timestamp = get_timestamp,
+   };
+   long cycles = *(long *)arg;
+   uint8_t outputs[RXPDO_BYTES] = { 0 };
+   uint8_t inputs[TXPDO_BYTES];
+   uint8_t expected;
+   uint64_t start, elapsed = 0;
+   long n, errors = 0;
+
+   if (use_irq)
+   {
+      config.use_interrupt = 1;
+      config.esc_hw_interrupt_enable = ESC_interrupt_enable;
+      config.esc_hw_interrupt_disable = ESC_interrupt_disable;
+   }
+   ecat_slv_init (&config);
+
+   if (use_irq)
+   {
+      esc_irq_cfg_t irq =
+      {
+         .source = ESC_IRQ_EVENTFD,
+         .device = NULL,
+         .line = 0,
+         .fd = ESC_sim_irq_fd(),
+         .isr_priority = 0,
+         .worker_priority = 0,
+      };
+
+      if (ESC_irq_start (&irq) != 0)
+      {
+         return 1;
+      }
+   }
+
+   master_sm_config (0, MBX0_sma, MBX0_sml, MBX0_smc);
+   master_sm_config (1, MBX1_sma, MBX1_sml, MBX1_smc);
+   if (master_request_state (ESCpreop) != 0)
+   {
+      ESC_irq_stop();
+      return 1;
+   }
+
+   master_sm_config (2, SM2_sma, RXPDO_BYTES, SM2_smc);
+   master_sm_config (3, SM3_sma, TXPDO_BYTES, SM3_smc);
+   if ((master_request_state (ESCsafeop) != 0) ||
+       (master_request_state (ESCop) != 0))
+   {
+      ESC_irq_stop();
+      return 1;
+   }
+
+   for (n = 0; n < cycles; n++)
+   {
+#if USE_TRIPLE_BUFFER
+      /* The inputs lag a cycle, they are made from the outputs the
+       * application read after the previous cycle
+       */
+      expected = (uint8_t)(outputs[0] ^ outputs[1]);
+#endif
+      outputs[0] = (uint8_t)n;
+      outputs[1] = (uint8_t)(n >> 8);
+#if !USE_TRIPLE_BUFFER
+      expected = (uint8_t)(outputs[0] ^ outputs[1]);
+#endif
+      /* In interrupt mode the write wakes the stack, time it as well */
+      start = time_ns();
+      ESC_sim_ecat_write (SM2_sma, outputs, sizeof (outputs));
+      if (use_irq)
+      {
+         if (wait_inputs (expected, inputs) != 0)
+         {
+            errors++;
+         }
+         elapsed += time_ns() - start;
+      }
+      else
+      {
+         start = time_ns();
+         ecat_slv();
+         elapsed += time_ns() - start;
+
+         ESC_sim_ecat_read (SM3_sma, inputs, sizeof (inputs));
+         if (inputs[0] != expected)
+         {
+            errors++;
+         }
+      }
+#if USE_TRIPLE_BUFFER
+      if (app_cycle() != 0)
+      {
+         errors++;
+      }
+#endif
+#if USE_STATS
+      drain_stats ();
+#endif
+   }
+
+   printf ("%ld cycles, mean %.1f ns per %s, %ld process data errors\n",
+           cycles, (cycles > 0) ? (double)elapsed / (double)cycles : 0.0,
+           use_irq ? "interrupt round trip" : "ecat_slv()", errors);
+#if USE_STATS
+   /* Before stopping the interrupt threads, they serve the SDO uploads */
+   print_stats ();
+#endif
+   ESC_irq_stop();
+
+   return (errors == 0) ? 0 : 1;
+}
+
+int main (int argc, char * argv[])
+{
+   long cycles = 100000;
+   int opt;
+
+   while ((opt = getopt (argc, argv, "ih")) != -1)
+   {
+      switch (opt)
+      {
+         case 'i':
+            use_irq = 1;
+            break;
+         default:
+            printf ("Usage: %s [-i] [cycles]\n", argv[0]);
+            printf ("  -i   interrupt driven, the simulator IRQ wakes the stack\n");
+            return 1;
+      }
+   }
+   if (optind < argc)
+   {
+      cycles = strtol (argv[optind], NULL, 0);
+   }
+   printf ("Hello Main\n");
+   return main_run (&cycles);
+}
@@ -0,0 +1,91 @@
+#ifndef __UTYPES_H__
+#define __UTYPES_H__
+
+#include "cc.h"
+
+/* Object dictionary storage */
+
+typedef struct
+{
+   /* Identity */
+
+   /* Inputs */
+
+   struct
+   {
+      uint8_t Button1;
+   } Buttons;
+
+   /* Outputs */
+
+   struct
+   {
+      uint8_t LED0;
+      uint8_t LED1;
+   } LEDs;
+
+   /* Parameters */
+
+   struct
+   {
+      uint32_t Multiplier;
+   } Parameters;
+
+   /* Sync Manager parameters, updated from the stats on upload */
+
+   struct
+   {
+      uint32_t Calc_and_Copy_Time;
+      uint16_t SM_Event_Missed_Counter;
+      uint16_t Cycle_Time_Too_Small_Counter;
+      uint32_t Minimum_Cycle_Distance;
+      uint32_t Maximum_Cycle_Distance;
+   } SM2Parameters;
+
+   struct
+   {
+      uint32_t Calc_and_Copy_Time;
+      uint16_t SM_Event_Missed_Counter;
+      uint16_t Cycle_Time_Too_Small_Counter;
+      uint32_t Minimum_Cycle_Distance;
+      uint32_t Maximum_Cycle_Distance;
+   } SM3Parameters;
+
+   /* Manufacturer specific data */
+
+   /* Dynamic TX PDO:s */
+
+   /* Dynamic RX PDO:s */
+
+   /* Dynamic Sync Managers */
+
+} _Objects;
+
+extern _Objects Obj;
+extern const _Objects ObjDefaults;
+
+/* Object positions in SDOobjects, usable instead of a lookup */
+
+#define SDO_OBJ_1000            0
+#define SDO_OBJ_1008            1
+#define SDO_OBJ_1009            2
+#define SDO_OBJ_100A            3
+#define SDO_OBJ_1018            4
+#define SDO_OBJ_1600            5
+#define SDO_OBJ_1A00            6
+#define SDO_OBJ_1C00            7
+#define SDO_OBJ_1C12            8
+#define SDO_OBJ_1C13            9
+#define SDO_OBJ_1C32            10
+#define SDO_OBJ_1C33            11
+#define SDO_OBJ_6000            12
+#define SDO_OBJ_7000            13
+#define SDO_OBJ_8000            14
+#define SDO_OBJECTS             15
+
+/* Process data sizes in bytes of the default PDO assignment */
+
+#define DEFAULT_RXPDO_SIZE      2
+#define DEFAULT_TXPDO_SIZE      1
+
+#endif /* __UTYPES_H__ */
@@ -42,8 +42,39 @@ typedef struct
       uint32_t Multiplier;
    } Parameters;
 
+   /* Manufacturer specific data */
+
+   /* Dynamic TX PDO:s */
+
+   /* Dynamic RX PDO:s */
+
+   /* Dynamic Sync Managers */
+
 } _Objects;
 
 extern _Objects Obj;
+extern const _Objects ObjDefaults;
+
+/* Object positions in SDOobjects, usable instead of a lookup */
+
+#define SDO_OBJ_1000            0
+#define SDO_OBJ_1008            1
+#define SDO_OBJ_1009            2
+#define SDO_OBJ_100A            3
+#define SDO_OBJ_1018            4
+#define SDO_OBJ_1600            5
+#define SDO_OBJ_1A00            6
+#define SDO_OBJ_1C00            7
+#define SDO_OBJ_1C12            8
+#define SDO_OBJ_1C13            9
+#define SDO_OBJ_6000            10
+#define SDO_OBJ_7000            11
+#define SDO_OBJ_8000            12
+#define SDO_OBJECTS             13
+
+/* Process data sizes in bytes of the default PDO assignment */
+
+#define DEFAULT_RXPDO_SIZE      1
+#define DEFAULT_TXPDO_SIZE      1
 
 #endif /* __UTYPES_H__ */
@@ -0,0 +1,331 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+ /** \file
+ * \brief
+ * Cycle time benchmark of the DIG_process hot path.
+ *
+ * The slave runs on the in-memory ESC simulator. A PDO mapping is built for
+ * the selected scenario, the slave is taken to OP through the regular state
+ * machine and DIG_process(OUTPUTS | INPUTS) is timed cycle by cycle.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ecat_slv.h"
+#include "esc_hw.h"
+#include "utypes.h"
+
+#define STATE_TIMEOUT   1000
+
+/* Entry types, offset from the 0x6000/0x7000 base index */
+#define TYPE_BIT1       0
+#define TYPE_U8         1
+#define TYPE_U16        2
+#define TYPE_U32        3
+#define TYPE_U64        4
+
+typedef struct
+{
+   const char * name;
+   const char * description;
+   const uint8_t * types;
+   size_t n_types;
+} scenario_t;
+
+static const uint8_t aligned_types[] =
+{
+   TYPE_U8, TYPE_U16, TYPE_U32, TYPE_U64
+};
+static const uint8_t bits_types[] =
+{
+   TYPE_BIT1
+};
+static const uint8_t unaligned_types[] =
+{
+   TYPE_BIT1, TYPE_U8, TYPE_U16, TYPE_BIT1, TYPE_BIT1, TYPE_U32,
+   TYPE_U64, TYPE_BIT1, TYPE_BIT1, TYPE_BIT1
+};
+static const uint8_t block_types[] =
+{
+   TYPE_U32
+};
+static const uint8_t type_bits[] = { 1, 8, 16, 32, 64 };
+
+static const scenario_t scenarios[] =
+{
+   { "aligned", "byte aligned 8/16/32/64 bit entries",
+     aligned_types, sizeof (aligned_types) },
+   { "bits", "1 bit entries only",
+     bits_types, sizeof (bits_types) },
+   { "unaligned", "mixed 1/8/16/32/64 bit entries on unaligned offsets",
+     unaligned_types, sizeof (unaligned_types) },
+   { "block", "32 bit entries laid out consecutively in memory",
+     block_types, sizeof (block_types) },
+};
+
+/* Application variables */
+_Objects    Obj;
+
+static int loopback;
+
+void cb_get_inputs (void)
+{
+   if (loopback)
+   {
+      memcpy (&Obj.Inputs, &Obj.Outputs, sizeof (Obj.Inputs));
+   }
+}
+
+void cb_set_outputs (void)
+{
+}
+
+/* Configure a SyncManager the way the master does */
+static void master_sm_config (uint8_t n, uint16_t psa, uint16_t length,
+                              uint8_t control)
+{
+   uint8_t sm[7];
+
+   sm[0] = (uint8_t)(psa & 0xFF);
+   sm[1] = (uint8_t)(psa >> 8);
+   sm[2] = (uint8_t)(length & 0xFF);
+   sm[3] = (uint8_t)(length >> 8);
+   sm[4] = control;
+   sm[5] = 0;
+   sm[6] = (length > 0) ? ESCREG_SMENABLE_BIT : 0;
+   ESC_sim_ecat_write ((uint16_t)(ESCREG_SM0 + (n << 3)), sm, sizeof (sm));
+}
+
+/* Request a state and run the stack until the slave has reached it */
+static int master_request_state (uint8_t state)
+{
+   uint16_t alcontrol = htoes (state);
+   uint16_t alstatus = 0;
+   int i;
+
+   ESC_sim_ecat_write (ESCREG_ALCONTROL, &alcontrol, sizeof (alcontrol));
+   for (i = 0; i < STATE_TIMEOUT; i++)
+   {
+      ecat_slv();
+      ESC_sim_ecat_read (ESCREG_ALSTATUS, &alstatus, sizeof (alstatus));
+      if ((etohs (alstatus) & ESCREG_AL_STATEMASK) == state)
+      {
+         return 0;
+      }
+   }
+   printf ("Failed to reach state 0x%x, AL status 0x%x\n", state,
+           etohs (alstatus));
+   return -1;
+}
+
+/* Build identical RxPDO and TxPDO mappings, returns size in bits */
+static uint32_t build_mapping (const scenario_t * scenario, int entries)
+{
+   uint8_t next_sub[sizeof (type_bits)] = { 0 };
+   uint32_t bits = 0;
+   int n;
+
+   for (n = 0; n < entries; n++)
+   {
+      uint8_t type = scenario->types[(size_t)n % scenario->n_types];
+      uint8_t sub = ++next_sub[type];
+      uint32_t entry = ((uint32_t)sub << 8) | type_bits[type];
+
+      Obj.RxPDO.value[n] = ((uint32_t)(0x7000 + type) << 16) | entry;
+      Obj.TxPDO.value[n] = ((uint32_t)(0x6000 + type) << 16) | entry;
+      bits += type_bits[type];
+   }
+   Obj.RxPDO.maxsub = (uint8_t)entries;
+   Obj.TxPDO.maxsub = (uint8_t)entries;
+
+   return bits;
+}
+
+static uint64_t time_ns (void)
+{
+   struct timespec ts;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u32 (const void * a, const void * b)
+{
+   uint32_t x = *(const uint32_t *)a;
+   uint32_t y = *(const uint32_t *)b;
+
+   return (x > y) - (x < y);
+}
+
+/* Run one cycle as master and slave, returns slave time in ns */
+static uint32_t cycle (uint8_t * outputs, uint8_t * inputs, uint16_t bytes)
+{
+   uint64_t start, stop;
+
+   ESC_sim_ecat_write (SM2_sma, outputs, bytes);
+   CC_ATOMIC_SET (ESCvar.ALevent, ESC_ALeventread());
+
+   start = time_ns();
+   DIG_process (DIG_PROCESS_OUTPUTS_FLAG | DIG_PROCESS_INPUTS_FLAG);
+   stop = time_ns();
+
+   ESC_sim_ecat_read (SM3_sma, inputs, bytes);
+   return (uint32_t)(stop - start);
+}
+
+static void usage (const char * name)
+{
+   size_t n;
+
+   printf ("Usage: %s [-s scenario] [-n entries] [-c cycles]\n", name);
+   printf ("  -s scenario   PDO mapping scenario, default %s\n",
+           scenarios[0].name);
+   printf ("  -n entries    mapped entries per direction, 1..%d, default 32\n",
+           MAX_MAPPINGS_SM2);
+   printf ("  -c cycles     number of timed cycles, default 100000\n");
+   printf ("Scenarios:\n");
+   for (n = 0; n < sizeof (scenarios) / sizeof (scenarios[0]); n++)
+   {
+      printf ("  %-12s  %s\n", scenarios[n].name, scenarios[n].description);
+   }
+}
+
+int main (int argc, char * argv[])
+{
+   static esc_cfg_t config =
+   {
+      .user_arg = NULL,
+      .use_interrupt = 0,
+      .watchdog_cnt = INT32_MAX,
+      .set_defaults_hook = NULL,
+      .pre_state_change_hook = NULL,
+      .post_state_change_hook = NULL,
+      .application_hook = NULL,
+      .safeoutput_override = NULL,
+      .pre_object_download_hook = NULL,
+      .post_object_download_hook = NULL,
+      .rxpdo_override = NULL,
+      .txpdo_override = NULL,
+      .esc_hw_interrupt_enable = NULL,
+      .esc_hw_interrupt_disable = NULL,
+      .esc_hw_eep_handler = NULL,
+      .esc_check_dc_handler = NULL,
+   };
+   const scenario_t * scenario = &scenarios[0];
+   static uint8_t outputs[MAX_RXPDO_SIZE];
+   static uint8_t inputs[MAX_TXPDO_SIZE];
+   uint32_t * samples;
+   uint32_t bits;
+   uint16_t bytes;
+   long cycles = 100000;
+   long n;
+   int entries = 32;
+   uint64_t sum = 0;
+   double mean;
+   int opt;
+
+   while ((opt = getopt (argc, argv, "s:n:c:h")) != -1)
+   {
+      switch (opt)
+      {
+         case 's':
+         {
+            size_t i;
+
+            scenario = NULL;
+            for (i = 0; i < sizeof (scenarios) / sizeof (scenarios[0]); i++)
+            {
+               if (strcmp (optarg, scenarios[i].name) == 0)
+               {
+                  scenario = &scenarios[i];
+               }
+            }
+            break;
+         }
+         case 'n':
+            entries = atoi (optarg);
+            break;
+         case 'c':
+            cycles = atol (optarg);
+            break;
+         default:
+            usage (argv[0]);
+            return 1;
+      }
+   }
+   if ((scenario == NULL) || (entries < 1) || (entries > MAX_MAPPINGS_SM2) ||
+       (entries > MAX_MAPPINGS_SM3) || (cycles < 1))
+   {
+      usage (argv[0]);
+      return 1;
+   }
+
+   bench_objectlist_init();
+   ecat_slv_init (&config);
+
+   bits = build_mapping (scenario, entries);
+   bytes = (uint16_t)((bits + 7) / 8);
+
+   master_sm_config (0, MBX0_sma, MBX0_sml, MBX0_smc);
+   master_sm_config (1, MBX1_sma, MBX1_sml, MBX1_smc);
+   if (master_request_state (ESCpreop) != 0)
+   {
+      return 1;
+   }
+   master_sm_config (2, SM2_sma, bytes, SM2_smc);
+   master_sm_config (3, SM3_sma, bytes, SM3_smc);
+   if ((master_request_state (ESCsafeop) != 0) ||
+       (master_request_state (ESCop) != 0))
+   {
+      return 1;
+   }
+
+   /* Check that the process data makes it through the stack unchanged */
+   for (n = 0; n < bytes; n++)
+   {
+      outputs[n] = (uint8_t)rand();
+   }
+   loopback = 1;
+   cycle (outputs, inputs, bytes);
+   cycle (outputs, inputs, bytes);
+   loopback = 0;
+   if (bits % 8)
+   {
+      uint8_t mask = (uint8_t)((1U << (bits % 8)) - 1);
+      outputs[bytes - 1] &= mask;
+      inputs[bytes - 1] &= mask;
+   }
+   if (memcmp (outputs, inputs, bytes) != 0)
+   {
+      printf ("Process data loopback mismatch\n");
+      return 1;
+   }
+
+   samples = malloc ((size_t)cycles * sizeof (samples[0]));
+   if (samples == NULL)
+   {
+      return 1;
+   }
+   for (n = 0; n < cycles; n++)
+   {
+      outputs[n % bytes] = (uint8_t)n;
+      samples[n] = cycle (outputs, inputs, bytes);
+      sum += samples[n];
+   }
+   qsort (samples, (size_t)cycles, sizeof (samples[0]), compare_u32);
+   mean = (double)sum / (double)cycles;
+
+   printf ("scenario %s, %d entries, %u bytes per direction, %ld cycles\n",
+           scenario->name, entries, bytes, cycles);
+   printf ("min %u ns, mean %.1f ns, p99 %u ns, max %u ns, %.0f cycles/s\n",
+           samples[0], mean, samples[(cycles * 99) / 100], samples[cycles - 1],
+           1e9 / mean);
+
+   free (samples);
+   return 0;
+}
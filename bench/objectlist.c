@@ -0,0 +1,179 @@
+#include "esc_coe.h"
+#include "utypes.h"
+#include <stddef.h>
+
+/* Object descriptions of the array objects are filled in at start-up by
+ * bench_objectlist_init, since they only differ in sub-index and data.
+ */
+
+static const char acName1000[] = "Device Type";
+static const char acName1018[] = "Identity Object";
+static const char acName1018_00[] = "Max SubIndex";
+static const char acName1018_01[] = "Vendor ID";
+static const char acName1018_02[] = "Product Code";
+static const char acName1018_03[] = "Revision Number";
+static const char acName1018_04[] = "Serial Number";
+static const char acName1600[] = "Outputs";
+static const char acName1A00[] = "Inputs";
+static const char acName1C00[] = "Sync Manager Communication Type";
+static const char acName1C00_01[] = "Communications Type SM0";
+static const char acName1C00_02[] = "Communications Type SM1";
+static const char acName1C00_03[] = "Communications Type SM2";
+static const char acName1C00_04[] = "Communications Type SM3";
+static const char acName1C12[] = "Sync Manager 2 PDO Assignment";
+static const char acName1C13[] = "Sync Manager 3 PDO Assignment";
+static const char acName6000[] = "Inputs BIT1";
+static const char acName6001[] = "Inputs UNSIGNED8";
+static const char acName6002[] = "Inputs UNSIGNED16";
+static const char acName6003[] = "Inputs UNSIGNED32";
+static const char acName6004[] = "Inputs UNSIGNED64";
+static const char acName7000[] = "Outputs BIT1";
+static const char acName7001[] = "Outputs UNSIGNED8";
+static const char acName7002[] = "Outputs UNSIGNED16";
+static const char acName7003[] = "Outputs UNSIGNED32";
+static const char acName7004[] = "Outputs UNSIGNED64";
+static const char acNameMaxSub[] = "Max SubIndex";
+static const char acNameEntry[] = "Entry";
+static const char acNameMapping[] = "PDO Mapping";
+
+const _objd SDO1000[] =
+{
+  {0x0, DTYPE_UNSIGNED32, 32, ATYPE_RO, acName1000, 0x01901389, NULL},
+};
+const _objd SDO1018[] =
+{
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1018_00, 4, NULL},
+  {0x01, DTYPE_UNSIGNED32, 32, ATYPE_RO, acName1018_01, 0x1337, NULL},
+  {0x02, DTYPE_UNSIGNED32, 32, ATYPE_RO, acName1018_02, 0xbe7c4, NULL},
+  {0x03, DTYPE_UNSIGNED32, 32, ATYPE_RO, acName1018_03, 0, NULL},
+  {0x04, DTYPE_UNSIGNED32, 32, ATYPE_RO, acName1018_04, 0x00000000, NULL},
+};
+const _objd SDO1C00[] =
+{
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acNameMaxSub, 4, NULL},
+  {0x01, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1C00_01, 1, NULL},
+  {0x02, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1C00_02, 2, NULL},
+  {0x03, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1C00_03, 3, NULL},
+  {0x04, DTYPE_UNSIGNED8, 8, ATYPE_RO, acName1C00_04, 4, NULL},
+};
+const _objd SDO1C12[] =
+{
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acNameMaxSub, 1, NULL},
+  {0x01, DTYPE_UNSIGNED16, 16, ATYPE_RO, acNameMapping, 0x1600, NULL},
+};
+const _objd SDO1C13[] =
+{
+  {0x00, DTYPE_UNSIGNED8, 8, ATYPE_RO, acNameMaxSub, 1, NULL},
+  {0x01, DTYPE_UNSIGNED16, 16, ATYPE_RO, acNameMapping, 0x1A00, NULL},
+};
+
+static _objd SDO1600[MAX_MAPPINGS_SM2 + 1];
+static _objd SDO1A00[MAX_MAPPINGS_SM3 + 1];
+static _objd SDO6000[BENCH_ARRAY_SIZE + 1];
+static _objd SDO6001[BENCH_ARRAY_SIZE + 1];
+static _objd SDO6002[BENCH_ARRAY_SIZE + 1];
+static _objd SDO6003[BENCH_ARRAY_SIZE + 1];
+static _objd SDO6004[BENCH_ARRAY_SIZE + 1];
+static _objd SDO7000[BENCH_ARRAY_SIZE + 1];
+static _objd SDO7001[BENCH_ARRAY_SIZE + 1];
+static _objd SDO7002[BENCH_ARRAY_SIZE + 1];
+static _objd SDO7003[BENCH_ARRAY_SIZE + 1];
+static _objd SDO7004[BENCH_ARRAY_SIZE + 1];
+
+const _objectlist SDOobjects[] =
+{
+  {0x1000, OTYPE_VAR, 0, 0, acName1000, SDO1000},
+  {0x1018, OTYPE_RECORD, 4, 0, acName1018, SDO1018},
+  {0x1600, OTYPE_RECORD, MAX_MAPPINGS_SM2, 0, acName1600, SDO1600},
+  {0x1A00, OTYPE_RECORD, MAX_MAPPINGS_SM3, 0, acName1A00, SDO1A00},
+  {0x1C00, OTYPE_ARRAY, 4, 0, acName1C00, SDO1C00},
+  {0x1C12, OTYPE_ARRAY, 1, 0, acName1C12, SDO1C12},
+  {0x1C13, OTYPE_ARRAY, 1, 0, acName1C13, SDO1C13},
+  {0x6000, OTYPE_ARRAY, BENCH_ARRAY_SIZE, 0, acName6000, SDO6000},
+  {0x6001, OTYPE_ARRAY, BENCH_ARRAY_SIZE, 0, acName6001, SDO6001},
+  {0x6002, OTYPE_ARRAY, BENCH_ARRAY_SIZE, 0, acName6002, SDO6002},
+  {0x6003, OTYPE_ARRAY, BENCH_ARRAY_SIZE, 0, acName6003, SDO6003},
+  {0x6004, OTYPE_ARRAY, BENCH_ARRAY_SIZE, 0, acName6004, SDO6004},
+  {0x7000, OTYPE_ARRAY, BENCH_ARRAY_SIZE, 0, acName7000, SDO7000},
+  {0x7001, OTYPE_ARRAY, BENCH_ARRAY_SIZE, 0, acName7001, SDO7001},
+  {0x7002, OTYPE_ARRAY, BENCH_ARRAY_SIZE, 0, acName7002, SDO7002},
+  {0x7003, OTYPE_ARRAY, BENCH_ARRAY_SIZE, 0, acName7003, SDO7003},
+  {0x7004, OTYPE_ARRAY, BENCH_ARRAY_SIZE, 0, acName7004, SDO7004},
+  {0xffff, 0xff, 0xff, 0xff, NULL, NULL}
+};
+
+static void init_maxsub (_objd * objd, uint8_t maxsub, void * data)
+{
+   objd->subindex = 0;
+   objd->datatype = DTYPE_UNSIGNED8;
+   objd->bitlength = 8;
+   objd->flags = ATYPE_RO;
+   objd->name = acNameMaxSub;
+   objd->value = maxsub;
+   objd->data = data;
+}
+
+static void init_array (_objd * objd, uint16_t datatype, uint16_t bitlength,
+                        uint16_t flags, uint8_t * data, size_t size)
+{
+   uint16_t n;
+
+   init_maxsub (objd, BENCH_ARRAY_SIZE, NULL);
+   for (n = 1; n <= BENCH_ARRAY_SIZE; n++)
+   {
+      objd[n].subindex = n;
+      objd[n].datatype = datatype;
+      objd[n].bitlength = bitlength;
+      objd[n].flags = flags;
+      objd[n].name = acNameEntry;
+      objd[n].value = 0;
+      objd[n].data = data + (n - 1) * size;
+   }
+}
+
+static void init_mapping (_objd * objd, uint8_t * maxsub, uint32_t * value,
+                          uint8_t n_entries)
+{
+   uint16_t n;
+
+   init_maxsub (objd, 0, maxsub);
+   objd[0].flags = ATYPE_RWpre;
+   for (n = 1; n <= n_entries; n++)
+   {
+      objd[n].subindex = n;
+      objd[n].datatype = DTYPE_UNSIGNED32;
+      objd[n].bitlength = 32;
+      objd[n].flags = ATYPE_RWpre;
+      objd[n].name = acNameEntry;
+      objd[n].value = 0;
+      objd[n].data = &value[n - 1];
+   }
+}
+
+void bench_objectlist_init (void)
+{
+   init_mapping (SDO1600, &Obj.RxPDO.maxsub, Obj.RxPDO.value, MAX_MAPPINGS_SM2);
+   init_mapping (SDO1A00, &Obj.TxPDO.maxsub, Obj.TxPDO.value, MAX_MAPPINGS_SM3);
+
+   init_array (SDO6000, DTYPE_BIT1, 1, ATYPE_RO | ATYPE_TXPDO,
+               (uint8_t *)Obj.Inputs.Bit, sizeof (Obj.Inputs.Bit[0]));
+   init_array (SDO6001, DTYPE_UNSIGNED8, 8, ATYPE_RO | ATYPE_TXPDO,
+               (uint8_t *)Obj.Inputs.U8, sizeof (Obj.Inputs.U8[0]));
+   init_array (SDO6002, DTYPE_UNSIGNED16, 16, ATYPE_RO | ATYPE_TXPDO,
+               (uint8_t *)Obj.Inputs.U16, sizeof (Obj.Inputs.U16[0]));
+   init_array (SDO6003, DTYPE_UNSIGNED32, 32, ATYPE_RO | ATYPE_TXPDO,
+               (uint8_t *)Obj.Inputs.U32, sizeof (Obj.Inputs.U32[0]));
+   init_array (SDO6004, DTYPE_UNSIGNED64, 64, ATYPE_RO | ATYPE_TXPDO,
+               (uint8_t *)Obj.Inputs.U64, sizeof (Obj.Inputs.U64[0]));
+
+   init_array (SDO7000, DTYPE_BIT1, 1, ATYPE_RW | ATYPE_RXPDO,
+               (uint8_t *)Obj.Outputs.Bit, sizeof (Obj.Outputs.Bit[0]));
+   init_array (SDO7001, DTYPE_UNSIGNED8, 8, ATYPE_RW | ATYPE_RXPDO,
+               (uint8_t *)Obj.Outputs.U8, sizeof (Obj.Outputs.U8[0]));
+   init_array (SDO7002, DTYPE_UNSIGNED16, 16, ATYPE_RW | ATYPE_RXPDO,
+               (uint8_t *)Obj.Outputs.U16, sizeof (Obj.Outputs.U16[0]));
+   init_array (SDO7003, DTYPE_UNSIGNED32, 32, ATYPE_RW | ATYPE_RXPDO,
+               (uint8_t *)Obj.Outputs.U32, sizeof (Obj.Outputs.U32[0]));
+   init_array (SDO7004, DTYPE_UNSIGNED64, 64, ATYPE_RW | ATYPE_RXPDO,
+               (uint8_t *)Obj.Outputs.U64, sizeof (Obj.Outputs.U64[0]));
+}
@@ -0,0 +1,55 @@
+#ifndef __UTYPES_H__
+#define __UTYPES_H__
+
+#include "cc.h"
+#include "ecat_options.h"
+
+/* Number of sub-indexes in each of the benchmark array objects */
+#define BENCH_ARRAY_SIZE   128
+
+/* Object dictionary storage */
+
+typedef struct
+{
+   /* Inputs */
+   struct
+   {
+      uint8_t Bit[BENCH_ARRAY_SIZE];
+      uint8_t U8[BENCH_ARRAY_SIZE];
+      uint16_t U16[BENCH_ARRAY_SIZE];
+      uint32_t U32[BENCH_ARRAY_SIZE];
+      uint64_t U64[BENCH_ARRAY_SIZE];
+   } Inputs;
+
+   /* Outputs */
+   struct
+   {
+      uint8_t Bit[BENCH_ARRAY_SIZE];
+      uint8_t U8[BENCH_ARRAY_SIZE];
+      uint16_t U16[BENCH_ARRAY_SIZE];
+      uint32_t U32[BENCH_ARRAY_SIZE];
+      uint64_t U64[BENCH_ARRAY_SIZE];
+   } Outputs;
+
+   /* Dynamic TX PDO:s */
+   struct
+   {
+      uint8_t maxsub;
+      uint32_t value[MAX_MAPPINGS_SM3];
+   } TxPDO;
+
+   /* Dynamic RX PDO:s */
+   struct
+   {
+      uint8_t maxsub;
+      uint32_t value[MAX_MAPPINGS_SM2];
+   } RxPDO;
+
+} _Objects;
+
+extern _Objects Obj;
+
+/** Fill in the benchmark object descriptions, call before stack init */
+void bench_objectlist_init (void);
+
+#endif /* __UTYPES_H__ */
@@ -0,0 +1,41 @@
+# Generate the object dictionary, object storage and SII EEPROM image of
+# an application from its .esx slave description with tools/esxgen.py.
+#
+#   esx_generate (<esx> <sources>)
+#
+# Sets <sources> to the generated files to add to the application target
+# and puts the generated utypes.h first in the include path of the current
+# directory. Everything, including the SII image <name>.bin, is written to
+# the current binary directory.
+
+option (SOES_ESX_GENERATE
+  "Generate object dictionary and SII EEPROM from the application .esx" OFF)
+
+find_program (PYTHON_EXECUTABLE NAMES python3 python)
+
+function (esx_generate esx sources)
+  if (NOT PYTHON_EXECUTABLE)
+    message (FATAL_ERROR "Python is needed to generate from ${esx}")
+  endif ()
+
+  get_filename_component (esx ${esx} ABSOLUTE)
+  get_filename_component (name ${esx} NAME_WE)
+  set (outdir ${CMAKE_CURRENT_BINARY_DIR})
+  set (outputs
+    ${outdir}/${name}_objectlist.c
+    ${outdir}/utypes.h
+    ${outdir}/${name}.bin
+    )
+
+  add_custom_command (
+    OUTPUT ${outputs}
+    COMMAND ${PYTHON_EXECUTABLE} ${SOES_SOURCE_DIR}/tools/esxgen.py
+      -o ${outdir} ${esx}
+    DEPENDS ${esx} ${SOES_SOURCE_DIR}/tools/esxgen.py
+    COMMENT "Generating object dictionary and SII EEPROM from ${name}.esx"
+    VERBATIM
+    )
+
+  include_directories (BEFORE ${outdir})
+  set (${sources} ${outputs} PARENT_SCOPE)
+endfunction ()
@@ -1,4 +1,30 @@
-if(RPI_VARIANT)
+if(BENCH_VARIANT)
+  set(SOES_DEMO bench)
+  set(HAL_SOURCES
+	${SOES_SOURCE_DIR}/soes/hal/sim/esc_hw.c
+	${SOES_SOURCE_DIR}/soes/hal/sim/esc_hw.h
+	)
+  include_directories(${SOES_SOURCE_DIR}/soes/hal/sim)
+elseif(SIM_VARIANT)
+  set(SOES_DEMO applications/linux_simdemo)
+  set(HAL_SOURCES
+	${SOES_SOURCE_DIR}/soes/hal/sim/esc_hw.c
+	${SOES_SOURCE_DIR}/soes/hal/sim/esc_hw.h
+	${SOES_SOURCE_DIR}/soes/hal/linux-irq/esc_irq.c
+	${SOES_SOURCE_DIR}/soes/hal/linux-irq/esc_irq.h
+	)
+  include_directories(${SOES_SOURCE_DIR}/soes/hal/sim)
+elseif(SPIDEV_VARIANT)
+  set(SOES_DEMO applications/linux_lan9252demo)
+  set(HAL_SOURCES
+	${SOES_SOURCE_DIR}/soes/hal/linux-spidev-lan9252/esc_hw.c
+	${SOES_SOURCE_DIR}/soes/hal/linux-spidev-lan9252/esc_hw.h
+	${SOES_SOURCE_DIR}/soes/hal/linux-irq/esc_irq.c
+	${SOES_SOURCE_DIR}/soes/hal/linux-irq/esc_irq.h
+	)
+  include_directories(${SOES_SOURCE_DIR}/soes/hal/linux-spidev-lan9252)
+  add_definitions(-DESC_DEVICE="/dev/spidev0.0")
+elseif(RPI_VARIANT)
   set (SOES_DEMO applications/raspberry_lan9252demo)
   set(HAL_SOURCES
 	${SOES_SOURCE_DIR}/soes/hal/raspberrypi-lan9252/esc_hw.c
@@ -8,13 +34,25 @@ else()
   set(SOES_DEMO applications/linux_lan9252demo)
   set(HAL_SOURCES
 	${SOES_SOURCE_DIR}/soes/hal/linux-lan9252/esc_hw.c
+	${SOES_SOURCE_DIR}/soes/hal/linux-lan9252/esc_hw.h
+	${SOES_SOURCE_DIR}/soes/hal/linux-irq/esc_irq.c
+	${SOES_SOURCE_DIR}/soes/hal/linux-irq/esc_irq.h
+	)
+  include_directories(
+	${SOES_SOURCE_DIR}/soes/hal/linux-lan9252
+	${SOES_SOURCE_DIR}/drivers/linux/lan9252
 	)
 endif()
 
 include_directories(
   ${SOES_SOURCE_DIR}/soes/include/sys/gcc
+  ${SOES_SOURCE_DIR}/soes/hal/linux-irq
   ${SOES_SOURCE_DIR}/${SOES_DEMO}
   )
 
+# HALs serialize ESC accesses for interrupt driven operation
+find_package(Threads REQUIRED)
+link_libraries(${CMAKE_THREAD_LIBS_INIT})
+
 # Common compile flags
 add_compile_options(-Wall -Wextra -Wconversion -Wno-unused-parameter -Werror)
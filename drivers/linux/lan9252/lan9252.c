@@ -8,9 +8,9 @@
 #include <linux/spi/spi.h>
 #include <linux/uaccess.h>
 #include <linux/miscdevice.h>
+#include <linux/slab.h>
 
-#define LAN9252_MAGIC 'l' //8bit=0~0xff 'l'an9252
-#define TEST _IO(LAN9252_MAGIC, 0)
+#include "lan9252.h"
 
 #define LAN9252_LOCK	mutex_lock(&lan9252_mutex);
 #define LAN9252_UNLOCK	mutex_unlock(&lan9252_mutex);
@@ -18,9 +18,22 @@
 #define DEVICE_NAME	"lan9252"
 
 /* spi command */
+#define SERIAL_WRITE	0x02
 #define FAST_READ	0x0B
 #define FAST_READ_DUMMY	1
 
+/* EtherCAT core CSR access registers */
+#define CSR_DATA_REG	0x300
+#define CSR_CMD_REG	0x304
+
+#define CSR_CMD_BUSY	(1U << 31)
+#define CSR_CMD_READ	((1U << 31) | (1U << 30))
+#define CSR_CMD_WRITE	(1U << 31)
+#define CSR_CMD_SIZE(x)	((x) << 16)
+
+/* Max number of CSR_CMD_REG polls before giving up */
+#define CSR_POLL_MAX	1000
+
 struct mutex lock;
 static DEFINE_MUTEX(lan9252_mutex);
 
@@ -258,6 +271,146 @@ out:
 	return ret;
 }
 
+static int lan9252_write_32(u16 address, u32 value)
+{
+	u8 command[7];
+
+	command[0] = SERIAL_WRITE;
+	command[1] = (address >> 8) & 0xff;
+	command[2] = address & 0xff;
+	command[3] = value & 0xff;
+	command[4] = (value >> 8) & 0xff;
+	command[5] = (value >> 16) & 0xff;
+	command[6] = (value >> 24) & 0xff;
+
+	return spi_write(lan9252, command, sizeof(command));
+}
+
+static int lan9252_read_32(u16 address, u32 *value)
+{
+	u8 command[4];
+	u8 result[4];
+	int ret;
+
+	command[0] = FAST_READ;
+	command[1] = (address >> 8) & 0xff;
+	command[2] = address & 0xff;
+	command[3] = FAST_READ_DUMMY;
+
+	ret = spi_write_then_read(lan9252, command, sizeof(command),
+					result, sizeof(result));
+	if (ret < 0)
+		return ret;
+
+	*value = result[0] | (result[1] << 8) | (result[2] << 16) |
+		((u32)result[3] << 24);
+
+	return 0;
+}
+
+/*
+	int lan9252_csr_op(struct lan9252_csr_op *op);
+	Description :	Execute one EtherCAT core CSR access, issue the
+			command, poll until done and fetch read data.
+	Retrun Value
+	0	:   success
+	other	:   fail
+*/
+static int lan9252_csr_op(struct lan9252_csr_op *op)
+{
+	u32 value;
+	int ret;
+	int i;
+
+	if (op->len != 1 && op->len != 2 && op->len != 4)
+		return -EINVAL;
+
+	if (op->write) {
+		ret = lan9252_write_32(CSR_DATA_REG, op->data);
+		if (ret < 0)
+			return ret;
+		value = CSR_CMD_WRITE;
+	} else {
+		value = CSR_CMD_READ;
+	}
+	value |= CSR_CMD_SIZE(op->len) | op->address;
+
+	ret = lan9252_write_32(CSR_CMD_REG, value);
+	if (ret < 0)
+		return ret;
+
+	for (i = 0; i < CSR_POLL_MAX; i++) {
+		ret = lan9252_read_32(CSR_CMD_REG, &value);
+		if (ret < 0)
+			return ret;
+		if (!(value & CSR_CMD_BUSY))
+			break;
+	}
+	if (i == CSR_POLL_MAX)
+		return -ETIMEDOUT;
+
+	if (!op->write)
+		return lan9252_read_32(CSR_DATA_REG, &op->data);
+
+	return 0;
+}
+
+/*
+	int lan9252_csr_batch(unsigned long argument);
+	Description :	Execute a list of CSR operations given by
+			struct lan9252_csr_batch.
+	Retrun Value
+	>= 0	:   number of executed operations
+	< 0	:   fail
+*/
+static int lan9252_csr_batch(unsigned long argument)
+{
+	struct lan9252_csr_batch batch;
+	struct lan9252_csr_op *ops;
+	size_t size;
+	int ret = 0;
+	u32 i;
+
+	if (copy_from_user(&batch, (void __user *)argument, sizeof(batch)))
+		return -EFAULT;
+
+	if (batch.count == 0)
+		return 0;
+	if (batch.count > LAN9252_CSR_BATCH_MAX)
+		return -EINVAL;
+
+	size = batch.count * sizeof(*ops);
+	ops = kmalloc(size, GFP_KERNEL);
+	if (!ops)
+		return -ENOMEM;
+
+	if (copy_from_user(ops, u64_to_user_ptr(batch.ops), size)) {
+		ret = -EFAULT;
+		goto kfree_ops;
+	}
+
+	for (i = 0; i < batch.count; i++) {
+		ret = lan9252_csr_op(&ops[i]);
+		if (ret < 0) {
+			dev_err(&lan9252->dev, "%s() csr 0x%x failed "
+				"ret=%d\n", __FUNCTION__, ops[i].address, ret);
+			goto kfree_ops;
+		}
+	}
+
+	if (copy_to_user(u64_to_user_ptr(batch.ops), ops, size)) {
+		ret = -EFAULT;
+		goto kfree_ops;
+	}
+
+	ret = batch.count;
+
+kfree_ops:
+	kfree(ops);
+
+	return ret;
+}
+
 static long lan9252_ioctl(struct file *file, unsigned int cmd,
 				unsigned long argument)
 {
@@ -266,12 +419,16 @@ static long lan9252_ioctl(struct file *file, unsigned int cmd,
 	LAN9252_LOCK;
 
 	switch (cmd) {
-		case TEST:
+		case LAN9252_TEST:
 			ret = lan9252_test();
 			break;
 
+		case LAN9252_CSR_BATCH:
+			ret = lan9252_csr_batch(argument);
+			break;
+
 		default:
-			ret = 0;
+			ret = -ENOTTY;
 			break;
 	}
 
@@ -0,0 +1,50 @@
+/*
+	Microchip LAN9252 driver user space interface
+*/
+#ifndef __LAN9252_H__
+#define __LAN9252_H__
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define LAN9252_MAGIC 'l' //8bit=0~0xff 'l'an9252
+
+/* Max number of CSR operations in one batch */
+#define LAN9252_CSR_BATCH_MAX	64
+
+/*
+	struct lan9252_csr_op
+	Description :	One access to the EtherCAT core CSR area through
+			the LAN9252 ECAT_CSR_CMD/ECAT_CSR_DATA registers.
+
+	address	: EtherCAT core CSR address
+	len	: access size in bytes, 1, 2 or 4
+	write	: 0 to read, 1 to write
+	data	: value to write, or value read on return
+*/
+struct lan9252_csr_op {
+	__u16 address;
+	__u8 len;
+	__u8 write;
+	__u32 data;
+};
+
+/*
+	struct lan9252_csr_batch
+	Description :	List of CSR operations executed in order, in one
+			ioctl call and without releasing the device.
+
+	ops	: user pointer to an array of struct lan9252_csr_op
+	count	: number of operations, at most LAN9252_CSR_BATCH_MAX
+*/
+struct lan9252_csr_batch {
+	__u64 ops;
+	__u32 count;
+	__u32 reserved;
+};
+
+#define LAN9252_TEST		_IO(LAN9252_MAGIC, 0)
+/* Returns the number of executed operations on success */
+#define LAN9252_CSR_BATCH	_IOWR(LAN9252_MAGIC, 1, struct lan9252_csr_batch)
+
+#endif /* __LAN9252_H__ */
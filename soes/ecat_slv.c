@@ -3,16 +3,20 @@
  * LICENSE file in the project root for full license information
  */
 #include <stddef.h>
+#include <string.h>
 #include "esc.h"
 #include "esc_coe.h"
 #include "esc_foe.h"
 #include "esc_eoe.h"
+#include "esc_stats.h"
 #include "ecat_slv.h"
 
 #define IS_RXPDO(index) ((index) >= 0x1600 && (index) < 0x1800)
 #define IS_TXPDO(index) ((index) >= 0x1A00 && (index) < 0x1C00)
 
-/* Global variables used by the stack */
+/* Global variables used by the stack. MBX is sized for the largest
+ * mailbox, the buffers in it are ESC_MBXSIZE apart
+ */
 uint8_t     MBX[MBXBUFFERS * MAX(MBXSIZE,MBXSIZEBOOT)];
 _MBXcontrol MBXcontrol[MBXBUFFERS];
 _SMmap      SMmap2[MAX_MAPPINGS_SM2];
@@ -28,12 +32,70 @@ static uint8_t rxpdo[MAX_RXPDO_SIZE] __attribute__((aligned (8)));
 extern uint8_t rxpdo[];
 #endif
 
-#if MAX_MAPPINGS_SM3 > 0
+#if USE_TRIPLE_BUFFER
+/* Inputs are written from the triple buffer images */
+#elif MAX_MAPPINGS_SM3 > 0
 static uint8_t txpdo[MAX_TXPDO_SIZE] __attribute__((aligned (8)));
 #else
 extern uint8_t txpdo[];
 #endif
 
+#if USE_TRIPLE_BUFFER
+#if (MAX_MAPPINGS_SM2 == 0) || (MAX_MAPPINGS_SM3 == 0)
+#error "USE_TRIPLE_BUFFER requires dynamic process data"
+#endif
+#if USE_ZEROCOPY_PDO || (MAX_RXPDO_RANGES > 0)
+#error "USE_TRIPLE_BUFFER excludes USE_ZEROCOPY_PDO and MAX_RXPDO_RANGES"
+#endif
+
+/* Triple buffer of process data images. The producer fills back and
+ * exchanges it with middle, the consumer exchanges front with middle
+ * when it holds a newer image, flagged by TB_NEW.
+ */
+#define TB_NEW      0x80
+#define TB_INDEX    0x03
+
+typedef struct
+{
+   uint8_t back;
+   uint8_t middle;
+   uint8_t front;
+} tb_t;
+
+/* Image size rounded up to keep every image 64-bit aligned */
+#define TB_SIZE(size) (((size) + 7U) & ~7U)
+
+static uint8_t rximage[3][TB_SIZE (MAX_RXPDO_SIZE)] __attribute__((aligned (8)));
+static uint8_t tximage[3][TB_SIZE (MAX_TXPDO_SIZE)] __attribute__((aligned (8)));
+static tb_t rxtb = { 0, 1, 2 };
+static tb_t txtb = { 0, 1, 2 };
+#endif
+
+#if (MAX_RXPDO_RANGES > 0) && (MAX_MAPPINGS_SM2 > 0)
+/* SM2 byte range, end excluded */
+typedef struct
+{
+   uint16_t start;
+   uint16_t end;
+} rxrange_t;
+
+/* Partial SM2 read plan, the mapped outputs consumed by the application
+ * and the byte ranges holding them, see RXPDO_plan */
+static _SMmap SMmap2i[MAX_MAPPINGS_SM2];
+static int rxmappings;
+static rxrange_t rxranges[MAX_RXPDO_RANGES];
+static int rxnranges;
+/* Ranges merged over bytes of objects not selected */
+static uint8_t rxgaps;
+#endif
+
+#if USE_TXPDO_DIRTY && (MAX_MAPPINGS_SM3 > 0)
+/* Image last written to each of the three SM3 buffers */
+static uint32_t txpdobuf[3][(MAX_TXPDO_SIZE + 3) / 4];
+/* SM3 buffer last written, as reported by the SM3 status */
+static uint8_t txpdolatest;
+#endif
+
 /** Function to pre-qualify the incoming SDO download.
  *
  * @param[in] index      = index of SDO download request to check
@@ -99,6 +161,10 @@ uint32_t ESC_upload_pre_objecthandler (uint16_t index,
       size_t *size,
       uint16_t flags)
 {
+#if USE_STATS
+   ESC_stats_upload (index);
+#endif
+
    if (ESCvar.pre_object_upload_hook != NULL)
    {
       return (ESCvar.pre_object_upload_hook) (index,
@@ -141,6 +207,172 @@ void APP_safeoutput (void)
    }
 }
 
+#if USE_TRIPLE_BUFFER
+/** Publish the back image of a triple buffer to the consumer.
+ *
+ * @param[in] tb   = triple buffer
+ */
+static void tb_publish (tb_t * tb)
+{
+   uint8_t back = CC_ATOMIC_XCHG (tb->middle, (uint8_t)(tb->back | TB_NEW));
+
+   tb->back = back & TB_INDEX;
+}
+
+/** Take the latest published image of a triple buffer as front image.
+ *
+ * @param[in] tb   = triple buffer
+ * @return 1 if a new image was published since the last call, else 0
+ */
+static int tb_acquire (tb_t * tb)
+{
+   if ((CC_ATOMIC_GET (tb->middle) & TB_NEW) == 0)
+   {
+      return 0;
+   }
+   tb->front = CC_ATOMIC_XCHG (tb->middle, tb->front) & TB_INDEX;
+   return 1;
+}
+
+/** Drop the image published to a triple buffer but not yet taken. The
+ * indexes are left as they are, the other side may be exchanging.
+ *
+ * @param[in] tb   = triple buffer
+ */
+static void tb_discard (tb_t * tb)
+{
+   CC_ATOMIC_AND (tb->middle, TB_INDEX);
+}
+
+/** Hook called from the slave stack on start and stop of the outputs,
+ * outputs read before aren't handed to the application after it.
+ */
+void APP_discardoutputs (void)
+{
+   tb_discard (&rxtb);
+}
+
+/** Hook called from the slave stack on start and stop of the inputs,
+ * inputs published before aren't written to Sync Manager 3 after it.
+ */
+void APP_discardinputs (void)
+{
+   tb_discard (&txtb);
+}
+
+/** Unpack the latest outputs read by DIG_process to the mapped objects.
+ * Called by the application, at its own rate, when USE_TRIPLE_BUFFER is
+ * set.
+ *
+ * @return 1 if new outputs were unpacked, 0 if none since the last call
+ */
+int ecat_slv_read_outputs (void)
+{
+   if (((CC_ATOMIC_GET (ESCvar.App.state) & APPSTATE_OUTPUT) == 0) ||
+       (tb_acquire (&rxtb) == 0))
+   {
+      return 0;
+   }
+   COE_pdoUnpack (rximage[rxtb.front], ESCvar.sm2mappings, SMmap2);
+   return 1;
+}
+
+/** Pack the mapped input objects and publish them, to be written by
+ * the next DIG_process. Called by the application, at its own rate,
+ * when USE_TRIPLE_BUFFER is set.
+ */
+void ecat_slv_write_inputs (void)
+{
+   if (CC_ATOMIC_GET (ESCvar.App.state) == APPSTATE_IDLE)
+   {
+      return;
+   }
+   COE_pdoPack (tximage[txtb.back], ESCvar.sm3mappings, SMmap3);
+   tb_publish (&txtb);
+}
+#endif
+
+#if USE_TXPDO_DIRTY && (MAX_MAPPINGS_SM3 > 0)
+/** Write the inputs to Sync Manager 3, leaving out what the ESC already
+ * holds. Nothing is written if the image equals the buffer last written,
+ * the master keeps reading that one. Otherwise the ESC puts the write in
+ * one of the other two buffers, so the 32-bit words differing from either
+ * of them are written, followed by the last byte completing the buffer.
+ *
+ * @param[in] image   = inputs image
+ * @param[in] length  = SM3 length
+ */
+static void TXPDO_write (uint8_t * image, uint16_t length)
+{
+   const uint32_t * latest = txpdobuf[txpdolatest];
+   const uint32_t * next = txpdobuf[(txpdolatest + 1) % 3];
+   const uint32_t * other = txpdobuf[(txpdolatest + 2) % 3];
+   uint8_t others = (uint8_t)(0x07 & ~(1U << txpdolatest));
+   uint8_t changed = ((ESCvar.txpdovalid & (1U << txpdolatest)) == 0);
+   uint16_t first = length;
+   uint16_t end = 0;
+   uint16_t n;
+   uint8_t status;
+
+   for (n = 0; n < length; n += 4)
+   {
+      uint16_t size = (uint16_t)MIN (4, length - n);
+      uint32_t word = 0;
+
+      /* Words are zero padded past the end of the image */
+      memcpy (&word, image + n, size);
+      if (word != latest[n / 4])
+      {
+         changed = 1;
+      }
+      if ((word != next[n / 4]) || (word != other[n / 4]))
+      {
+         if (first == length)
+         {
+            first = n;
+         }
+         end = (uint16_t)(n + size);
+      }
+   }
+   if (changed == 0)
+   {
+      return;
+   }
+   if ((ESCvar.txpdovalid & others) != others)
+   {
+      first = 0;
+      end = length;
+   }
+
+   if (end > first)
+   {
+      ESC_write ((uint16_t)(ESC_SM3_sma + first), image + first,
+                 (uint16_t)(end - first));
+   }
+   if (end < length)
+   {
+      ESC_write ((uint16_t)(ESC_SM3_sma + length - 1), image + length - 1, 1);
+   }
+
+   ESC_read (ESCREG_SM3STATUS, &status, sizeof (status));
+   status = (uint8_t)((status & ESCREG_SMSTATUS_BUFFER) >> 4);
+   if (status > 2)
+   {
+      ESCvar.txpdovalid = 0;
+      return;
+   }
+   if ((length % 4) != 0)
+   {
+      txpdobuf[status][length / 4] = 0;
+   }
+   memcpy (txpdobuf[status], image, length);
+   ESCvar.txpdovalid |= (uint8_t)(1U << status);
+   txpdolatest = status;
+}
+#else
+#define TXPDO_write(image, length) ESC_write (ESC_SM3_sma, image, length)
+#endif
+
 /** Write local process data to Sync Manager 3, Master Inputs.
  */
 void TXPDO_update (void)
@@ -151,12 +383,134 @@ void TXPDO_update (void)
    }
    else
    {
+#if USE_TRIPLE_BUFFER
+      uint32_t probe;
+
+      /* Taking the inputs published by the application */
+      probe = ESC_STATS_TIME();
+      tb_acquire (&txtb);
+      ESC_STATS_PROBE (ESC_STATS_GET_INPUTS, probe);
+      TXPDO_write (tximage[txtb.front], ESCvar.ESC_SM3_sml);
+#else
+#if USE_ZEROCOPY_PDO && (MAX_MAPPINGS_SM3 > 0)
+      void * image = COE_pdoImage (ESCvar.sm3mappings, SMmap3,
+                                   ESCvar.ESC_SM3_sml);
+      if (image != NULL)
+      {
+         TXPDO_write (image, ESCvar.ESC_SM3_sml);
+         return;
+      }
+#endif
       if (MAX_MAPPINGS_SM3 > 0)
       {
          COE_pdoPack (txpdo, ESCvar.sm3mappings, SMmap3);
       }
-      ESC_write (ESC_SM3_sma, txpdo, ESCvar.ESC_SM3_sml);
+      TXPDO_write (txpdo, ESCvar.ESC_SM3_sml);
+#endif
+   }
+}
+
+#if (MAX_RXPDO_RANGES > 0) && (MAX_MAPPINGS_SM2 > 0)
+/** Build the partial SM2 read plan from the SM2 mapping, keeping the
+ * objects selected by the rxpdo_interest hook. Their byte ranges are
+ * merged when adjacent, and over the smallest gap when there are more
+ * than MAX_RXPDO_RANGES of them.
+ */
+static void RXPDO_plan (void)
+{
+   int ix;
+
+   rxmappings = 0;
+   rxnranges = 0;
+   rxgaps = 0;
+   for (ix = 0; ix < ESCvar.sm2mappings; ix++)
+   {
+      const _SMmap * mapping = &SMmap2[ix];
+      const _objd * obj = mapping->obj;
+      uint16_t start;
+      uint16_t end;
+
+      if ((obj == NULL) ||
+          !ESCvar.rxpdo_interest (mapping->objectlistitem->index,
+                                  (uint8_t)obj->subindex))
+      {
+         continue;
+      }
+      SMmap2i[rxmappings++] = *mapping;
+
+      start = (uint16_t)(mapping->offset >> 3);
+      end = (uint16_t)((mapping->offset + obj->bitlength + 7U) >> 3);
+      if ((rxnranges > 0) && (start <= rxranges[rxnranges - 1].end))
+      {
+         rxranges[rxnranges - 1].end = MAX (rxranges[rxnranges - 1].end, end);
+         continue;
+      }
+      if (rxnranges == MAX_RXPDO_RANGES)
+      {
+         /* Merge over the smallest gap, the one to the new range included */
+         int merge = rxnranges - 1;
+         int gap = start - rxranges[merge].end;
+         int n;
+
+         rxgaps = 1;
+
+         for (n = 0; n < rxnranges - 1; n++)
+         {
+            if ((rxranges[n + 1].start - rxranges[n].end) < gap)
+            {
+               merge = n;
+               gap = rxranges[n + 1].start - rxranges[n].end;
+            }
+         }
+         if (merge == rxnranges - 1)
+         {
+            rxranges[merge].end = end;
+            continue;
+         }
+         rxranges[merge].end = rxranges[merge + 1].end;
+         for (n = merge + 1; n < rxnranges - 1; n++)
+         {
+            rxranges[n] = rxranges[n + 1];
+         }
+         rxnranges--;
+      }
+      rxranges[rxnranges].start = start;
+      rxranges[rxnranges].end = end;
+      rxnranges++;
    }
+   COE_pdoPlan (SMmap2i, rxmappings);
+}
+
+/** Read the planned SM2 ranges to the process data image, then the last
+ * SM2 byte if not already read, to release the buffer to the master. The
+ * release byte is not stored, the image may be the object storage.
+ *
+ * @param[in] image   = outputs image
+ * @param[in] length  = SM2 length
+ */
+static void RXPDO_read (uint8_t * image, uint16_t length)
+{
+   uint8_t release;
+   int n;
+
+   for (n = 0; n < rxnranges; n++)
+   {
+      ESC_read ((uint16_t)(ESC_SM2_sma + rxranges[n].start),
+                image + rxranges[n].start,
+                (uint16_t)(rxranges[n].end - rxranges[n].start));
+   }
+   if ((rxnranges == 0) || (rxranges[rxnranges - 1].end < length))
+   {
+      ESC_read ((uint16_t)(ESC_SM2_sma + length - 1), &release, 1);
+   }
+}
+#endif
+
+/** Rebuild the partial SM2 read plan before the next read of the outputs.
+ */
+void ecat_slv_rxpdo_replan (void)
+{
+   CC_ATOMIC_SET (ESCvar.rxpdoplanned, 0);
 }
 
 /** Read Sync Manager 2 to local process data, Master Outputs.
@@ -169,11 +523,53 @@ void RXPDO_update (void)
    }
    else
    {
+#if USE_TRIPLE_BUFFER
+      uint32_t probe;
+
+      ESC_read (ESC_SM2_sma, rximage[rxtb.back], ESCvar.ESC_SM2_sml);
+      /* Handing the outputs to the application */
+      probe = ESC_STATS_TIME();
+      tb_publish (&rxtb);
+      ESC_STATS_PROBE (ESC_STATS_SET_OUTPUTS, probe);
+#else
+#if USE_ZEROCOPY_PDO && (MAX_MAPPINGS_SM2 > 0)
+      void * image = COE_pdoImage (ESCvar.sm2mappings, SMmap2,
+                                   ESCvar.ESC_SM2_sml);
+#endif
+#if (MAX_RXPDO_RANGES > 0) && (MAX_MAPPINGS_SM2 > 0)
+      if ((ESCvar.rxpdo_interest != NULL) && (ESCvar.ESC_SM2_sml > 0))
+      {
+         if (CC_ATOMIC_GET (ESCvar.rxpdoplanned) == 0)
+         {
+            CC_ATOMIC_SET (ESCvar.rxpdoplanned, 1);
+            RXPDO_plan ();
+         }
+#if USE_ZEROCOPY_PDO
+         /* Ranges merged over gaps would overwrite objects not selected */
+         if ((image != NULL) && !rxgaps)
+         {
+            RXPDO_read (image, ESCvar.ESC_SM2_sml);
+            return;
+         }
+#endif
+         RXPDO_read (rxpdo, ESCvar.ESC_SM2_sml);
+         COE_pdoUnpack (rxpdo, rxmappings, SMmap2i);
+         return;
+      }
+#endif
+#if USE_ZEROCOPY_PDO && (MAX_MAPPINGS_SM2 > 0)
+      if (image != NULL)
+      {
+         ESC_read (ESC_SM2_sma, image, ESCvar.ESC_SM2_sml);
+         return;
+      }
+#endif
       ESC_read (ESC_SM2_sma, rxpdo, ESCvar.ESC_SM2_sml);
       if (MAX_MAPPINGS_SM2 > 0)
       {
          COE_pdoUnpack (rxpdo, ESCvar.sm2mappings, SMmap2);
       }
+#endif
    }
 }
 
@@ -193,6 +589,9 @@ void APP_setwatchdog (int watchdogcnt)
  */
 void DIG_process (uint8_t flags)
 {
+   uint32_t start = ESC_STATS_TIME();
+   uint32_t probe;
+
    /* Handle watchdog */
    if((flags & DIG_PROCESS_WD_FLAG) > 0)
    {
@@ -220,10 +619,17 @@ void DIG_process (uint8_t flags)
       if(((CC_ATOMIC_GET(ESCvar.App.state) & APPSTATE_OUTPUT) > 0) &&
          (ESCvar.ALevent & ESCREG_ALEVENT_SM2))
       {
+         ESC_STATS_SM2 (start);
+         probe = ESC_STATS_TIME();
          RXPDO_update();
+         ESC_STATS_PROBE (ESC_STATS_RXPDO_UPDATE, probe);
          CC_ATOMIC_SET(watchdog, ESCvar.watchdogcnt);
+#if !USE_TRIPLE_BUFFER
          /* Set outputs */
+         probe = ESC_STATS_TIME();
          cb_set_outputs();
+         ESC_STATS_PROBE (ESC_STATS_SET_OUTPUTS, probe);
+#endif
       }
       else if (ESCvar.ALevent & ESCREG_ALEVENT_SM2)
       {
@@ -246,11 +652,29 @@ void DIG_process (uint8_t flags)
    {
       if(CC_ATOMIC_GET(ESCvar.App.state) > 0)
       {
+#if !USE_TRIPLE_BUFFER
          /* Update inputs */
+         probe = ESC_STATS_TIME();
          cb_get_inputs();
+         ESC_STATS_PROBE (ESC_STATS_GET_INPUTS, probe);
+#endif
+         probe = ESC_STATS_TIME();
          TXPDO_update();
+         ESC_STATS_PROBE (ESC_STATS_TXPDO_UPDATE, probe);
       }
    }
+
+   ESC_STATS_PROBE (ESC_STATS_DIG_PROCESS, start);
+}
+
+/* Instrumented ESC_mbxprocess */
+static uint8_t mbxprocess (void)
+{
+   uint32_t start = ESC_STATS_TIME();
+   uint8_t result = ESC_mbxprocess();
+
+   ESC_STATS_PROBE (ESC_STATS_MBXPROCESS, start);
+   return result;
 }
 
 /*
@@ -268,7 +692,7 @@ void ecat_slv_worker (uint32_t event_mask)
       ESC_sm_act_event();
 
       /* Check mailboxes */
-      while ((ESC_mbxprocess() > 0) || (ESCvar.txcue > 0))
+      while ((mbxprocess() > 0) || (ESCvar.txcue > 0))
       {
          ESC_coeprocess();
 #if USE_FOE
@@ -312,16 +736,22 @@ void ecat_slv_poll (void)
    ESC_sm_act_event();
 
    /* Check mailboxes */
-   if (ESC_mbxprocess())
+   if (mbxprocess())
    {
-      ESC_coeprocess();
+      do
+      {
+         ESC_coeprocess();
 #if USE_FOE
-      ESC_foeprocess();
+         ESC_foeprocess();
 #endif
 #if USE_EOE
-      ESC_eoeprocess();
+         ESC_eoeprocess();
 #endif
-      ESC_xoeprocess();
+         ESC_xoeprocess();
+         /* Post a response right away if the outbox is free, that may also
+          * read the next inbox mailbox to be handled
+          */
+      } while ((ESCvar.txcue > 0) && (mbxprocess() > 0));
    }
 #if USE_EOE
    ESC_eoeprocess_tx();
@@ -354,6 +784,10 @@ void ecat_slv_init (esc_cfg_t * config)
    /* Init watchdog */
    watchdog = config->watchdog_cnt;
 
+#if USE_STATS
+   ESC_stats_reset ();
+#endif
+
    /* Call stack configuration */
    ESC_config (config);
    /* Call HW init */
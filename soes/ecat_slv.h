@@ -59,6 +59,26 @@ void ecat_slv_poll (void);
  */
 void ecat_slv (void);
 
+/**
+ * Unpack the latest outputs read by DIG_process to the mapped objects,
+ * used instead of cb_set_outputs when USE_TRIPLE_BUFFER is set
+ *
+ * @return 1 if new outputs were unpacked, 0 if none since the last call
+ */
+int ecat_slv_read_outputs (void);
+
+/**
+ * Pack the mapped input objects for the next DIG_process, used instead
+ * of cb_get_inputs when USE_TRIPLE_BUFFER is set
+ */
+void ecat_slv_write_inputs (void);
+
+/**
+ * Rebuild the partial SM2 read plan, to be called when the objects selected
+ * by the rxpdo_interest hook change, e.g. on a new mode of operation
+ */
+void ecat_slv_rxpdo_replan (void);
+
 /**
  * Initialize the slave stack
  *
@@ -9,6 +9,9 @@
 #include "esc_foe.h"
 
 CC_STATIC_ASSERT((MBXSIZE > ESC_MBXHSIZE) && (MBXSIZEBOOT > ESC_MBXHSIZE), "Mailbox size too small.");
+CC_STATIC_ASSERT((MIN_MBXSIZE > ESC_MBXHSIZE) && (MIN_MBXSIZEBOOT > ESC_MBXHSIZE), "Mailbox size too small.");
+CC_STATIC_ASSERT((MIN_MBXSIZE <= MBXSIZE) && (MIN_MBXSIZEBOOT <= MBXSIZEBOOT), "Mailbox size range empty.");
+CC_STATIC_ASSERT((MBXBUFFERS >= 3) && (MBXBUFFERS <= 255), "Mailbox buffers out of range.");
 
 /** \file
  * \brief
@@ -294,10 +297,31 @@ uint16_t ESC_checkDC (void)
    return ret;
 }
 
+/** Check that a mailbox SyncManager length set by the master is accepted.
+ * Any length from the smallest accepted size up to the configured length
+ * may be used when starting the mailboxes, while they run it may not
+ * change.
+ *
+ * @param[in] n       = SyncManager 0 or 1
+ * @param[in] length  = SyncManager length read from the ESC
+ * @param[in] cfg     = configured SyncManager settings
+ * @return 1 if accepted, otherwise 0
+ */
+static uint8_t ESC_checkmbxlength (uint8_t n, uint16_t length,
+                                   const sm_cfg_t * cfg)
+{
+   if (ESCvar.MBXrun)
+   {
+      return (length == ESCvar.activembxsml[n]);
+   }
+   return ((length >= ESCvar.activembxmin) && (length <= cfg->cfg_sml));
+}
+
 /** Check mailbox status by reading all SyncManager 0 and 1 data. The read values
  * are compared with local definitions for SM Physical Address, SM Length and SM Control.
  * If we check fails we disable Mailboxes by disabling SyncManager 0 and 1 and return
- * state Init with Error flag set.
+ * state Init with Error flag set. When starting the mailboxes the SM Lengths set by
+ * the master decide the mailbox sizes used.
  *
  * @param[in] state   = Current state request read from ALControl 0x0120
  * @return if all Mailbox values is correct we return incoming state request, otherwise
@@ -309,7 +333,8 @@ uint8_t ESC_checkmbx (uint8_t state)
    ESC_read (ESCREG_SM0, (void *) &ESCvar.SM[0], sizeof (ESCvar.SM[0]));
    ESC_read (ESCREG_SM1, (void *) &ESCvar.SM[1], sizeof (ESCvar.SM[1]));
    SM = (_ESCsm2 *) & ESCvar.SM[0];
-   if ((etohs (SM->PSA) != ESC_MBX0_sma) || (etohs (SM->Length) != ESC_MBX0_sml)
+   if ((etohs (SM->PSA) != ESC_MBX0_sma)
+       || !ESC_checkmbxlength (0, etohs (SM->Length), ESCvar.activemb0)
        || (SM->Command != ESC_MBX0_smc) || (ESCvar.SM[0].ECsm == 0))
    {
       ESCvar.SMtestresult = SMRESULT_ERRSM0;
@@ -318,7 +343,8 @@ uint8_t ESC_checkmbx (uint8_t state)
       return (uint8_t) (ESCinit | ESCerror);      //fail state change
    }
    SM = (_ESCsm2 *) & ESCvar.SM[1];
-   if ((etohs (SM->PSA) != ESC_MBX1_sma) || (etohs (SM->Length) != ESC_MBX1_sml)
+   if ((etohs (SM->PSA) != ESC_MBX1_sma)
+       || !ESC_checkmbxlength (1, etohs (SM->Length), ESCvar.activemb1)
        || (SM->Command != ESC_MBX1_smc) || (ESCvar.SM[1].ECsm == 0))
    {
       ESCvar.SMtestresult = SMRESULT_ERRSM1;
@@ -326,6 +352,14 @@ uint8_t ESC_checkmbx (uint8_t state)
       ESC_SMdisable (1);
       return ESCinit | ESCerror;        //fail state change
    }
+   if (!ESCvar.MBXrun)
+   {
+      /* Size the mailboxes as configured by the master */
+      ESCvar.activembxsml[0] = etohs (ESCvar.SM[0].Length);
+      ESCvar.activembxsml[1] = etohs (ESCvar.SM[1].Length);
+      ESCvar.activembxsize = MAX (ESCvar.activembxsml[0],
+                                  ESCvar.activembxsml[1]);
+   }
    return state;
 }
 /** Try to start mailboxes for current ALControl state request by enabling SyncManager 0 and 1.
@@ -340,7 +374,7 @@ uint8_t ESC_checkmbx (uint8_t state)
 uint8_t ESC_startmbx (uint8_t state)
 {
    /* Assign SM settings */
-   ESCvar.activembxsize = MBXSIZE;
+   ESCvar.activembxmin = MIN_MBXSIZE;
    ESCvar.activemb0 = &ESCvar.mb[0];
    ESCvar.activemb1 = &ESCvar.mb[1];
 
@@ -375,7 +409,7 @@ uint8_t ESC_startmbx (uint8_t state)
 uint8_t ESC_startmbxboot (uint8_t state)
 {
    /* Assign SM settings */
-   ESCvar.activembxsize = MBXSIZEBOOT;
+   ESCvar.activembxmin = MIN_MBXSIZEBOOT;
    ESCvar.activemb0 = &ESCvar.mbboot[0];
    ESCvar.activemb1 = &ESCvar.mbboot[1];
 
@@ -398,6 +432,18 @@ uint8_t ESC_startmbxboot (uint8_t state)
    return state;
 }
 
+/** Return an outbox mailbox buffer to the free list, for a buffer claimed
+ * but not posted or a disposed backup.
+ *
+ * @param[in] n   = Which local mailbox buffer n to release.
+ */
+void ESC_releasebuffer (uint8_t n)
+{
+   MBXcontrol[n].state = MBXstate_idle;
+   MBXcontrol[n].next = ESCvar.mbxidle;
+   ESCvar.mbxidle = n;
+}
+
 /** Stop mailboxes by disabling SyncManager 0 and 1. Clear local mailbox variables
  * stored in ESCvar.
  */
@@ -407,9 +453,18 @@ void ESC_stopmbx (void)
    ESCvar.MBXrun = 0;
    ESC_SMdisable (0);
    ESC_SMdisable (1);
-   for (n = 0; n < ESC_MBXBUFFERS; n++)
+   MBXcontrol[0].state = MBXstate_idle;
+   MBXcontrol[0].next = 0;
+   /* All outbox buffers idle, no requests queued */
+   ESCvar.mbxidle = 0;
+   for (n = ESC_MBXBUFFERS - 1; n > 0; n--)
    {
-      MBXcontrol[n].state = MBXstate_idle;
+      ESC_releasebuffer (n);
+   }
+   for (n = 0; n < MBXPRIORITIES; n++)
+   {
+      ESCvar.mbxqhead[n] = 0;
+      ESCvar.mbxqtail[n] = 0;
    }
    ESCvar.mbxoutpost = 0;
    ESCvar.mbxbackup = 0;
@@ -418,6 +473,7 @@ void ESC_stopmbx (void)
    ESCvar.toggle = 0;
    ESCvar.mbxincnt = 0;
    ESCvar.segmented = 0;
+   ESCvar.segnext = 0;
    ESCvar.frags = 0;
    ESCvar.fragsleft = 0;
    ESCvar.txcue = 0;
@@ -486,51 +542,85 @@ void ESC_ackmbxread (void)
    ESCvar.mbxfree = 1;
 }
 
-/** Allocate and prepare a mailbox buffer. Take the first Idle buffer from the End.
- * Set Mailbox control state to be used for outbox and fill the mailbox buffer with
- * address master and mailbox next CNT value between 1-7.
+/** Allocate and prepare a mailbox buffer. Take the first Idle buffer from the
+ * free list. Set Mailbox control state to be used for outbox and fill the mailbox
+ * buffer with address master. The mailbox CNT is set when it is sent.
+ * A buffer claimed while an inbox mailbox is handled is a response and gets
+ * the priority of the request, other buffers get the lowest priority.
  *
  * @return The index of Mailbox buffer prepared for outbox. IF no buffer is available return 0.
  */
 uint8_t ESC_claimbuffer (void)
 {
    _MBXh *MBh;
-   uint8_t n = ESC_MBXBUFFERS - 1;
-   while ((n > 0) && (MBXcontrol[n].state))
-   {
-      n--;
-   }
+   uint8_t n = ESCvar.mbxidle;
    if (n)
    {
+      ESCvar.mbxidle = MBXcontrol[n].next;
+      MBXcontrol[n].next = 0;
       MBXcontrol[n].state = MBXstate_outclaim;
       MBh = (_MBXh *)&MBX[n * ESC_MBXSIZE];
-      ESCvar.mbxcnt++;
-      ESCvar.mbxcnt = (ESCvar.mbxcnt & 0x07);
-      if (ESCvar.mbxcnt == 0)
-      {
-         ESCvar.mbxcnt = 1;
-      }
       MBh->address = htoes (0x0000);      // destination is master
       MBh->channel = 0;
-      MBh->priority = 0;
-      MBh->mbxcnt = ESCvar.mbxcnt & 0xFU;
-      ESCvar.txcue++;
+      if (MBXcontrol[0].state == MBXstate_inclaim)
+      {
+         MBh->priority = ((_MBXh *)&MBX[0])->priority;
+      }
+      else
+      {
+         MBh->priority = 0;
+      }
+      MBh->mbxcnt = 0;
    }
    return n;
 }
 
-/** Look for any present requests for posting to the outbox.
+/** Request posting of a claimed mailbox buffer to the outbox. Buffers are
+ * posted in order of request within the priority given in the mailbox
+ * header, higher priorities first.
+ *
+ * @param[in] n   = Which local mailbox buffer n to post.
+ */
+void ESC_mbxpost (uint8_t n)
+{
+   _MBXh *MBh = (_MBXh *)&MBX[n * ESC_MBXSIZE];
+   uint8_t prio = MBh->priority;
+
+   MBXcontrol[n].state = MBXstate_outreq;
+   MBXcontrol[n].next = 0;
+   if (ESCvar.mbxqhead[prio])
+   {
+      MBXcontrol[ESCvar.mbxqtail[prio]].next = n;
+   }
+   else
+   {
+      ESCvar.mbxqhead[prio] = n;
+   }
+   ESCvar.mbxqtail[prio] = n;
+   ESCvar.txcue++;
+}
+
+/** Take the next request for posting to the outbox.
  *
- * @return the index of Mailbox buffer ready to be posted.
+ * @return the index of Mailbox buffer ready to be posted, 0 if none.
  */
 uint8_t ESC_outreqbuffer (void)
 {
-   uint8_t n = ESC_MBXBUFFERS - 1;
-   while ((n > 0) && (MBXcontrol[n].state != MBXstate_outreq))
+   uint8_t prio = MBXPRIORITIES;
+   uint8_t n;
+
+   while (prio > 0)
    {
-      n--;
+      prio--;
+      n = ESCvar.mbxqhead[prio];
+      if (n)
+      {
+         ESCvar.mbxqhead[prio] = MBXcontrol[n].next;
+         MBXcontrol[n].next = 0;
+         return n;
+      }
    }
-   return n;
+   return 0;
 }
 /** Allocate and prepare a mailbox buffer for sending an error message. Take the first Idle
  * buffer from the end. Set Mailbox control state to be used for outbox and fill the mailbox
@@ -550,7 +640,7 @@ void MBX_error (uint16_t error)
       mbxerr->mbxheader.mbxtype = MBXERR;
       mbxerr->type = htoes ((uint16_t) 0x01);
       mbxerr->detail = htoes (error);
-      MBXcontrol[MBXout].state = MBXstate_outreq;
+      ESC_mbxpost (MBXout);
    }
 }
 
@@ -564,6 +654,7 @@ uint8_t ESC_mbxprocess (void)
 {
    uint8_t mbxhandle = 0;
    _MBXh *MBh = (_MBXh *)&MBX[0];
+   uint8_t result = 0;
 
    if (ESCvar.MBXrun == 0)
    {
@@ -585,12 +676,14 @@ uint8_t ESC_mbxprocess (void)
       /* dispose old backup */
       if (ESCvar.mbxbackup)
       {
-         MBXcontrol[ESCvar.mbxbackup].state = MBXstate_idle;
+         ESC_releasebuffer (ESCvar.mbxbackup);
       }
       /* if still to do */
       if (MBXcontrol[ESCvar.mbxoutpost].state == MBXstate_again)
       {
          ESC_writembx (ESCvar.mbxoutpost);
+         /* Refresh SM status, the outbox is full again */
+         ESC_SMstatus (1);
       }
       /* create new backup */
       MBXcontrol[ESCvar.mbxoutpost].state = MBXstate_backup;
@@ -599,9 +692,9 @@ uint8_t ESC_mbxprocess (void)
       /* Do we have any ongoing protocol transfers, return 1 */
       if(ESCvar.xoe > 0)
       {
-         return 1;
+         result = 1;
       }
-      return 0;
+      /* go on posting the next outbox and reading the inbox */
    }
 
    /* repeat request */
@@ -630,7 +723,7 @@ uint8_t ESC_mbxprocess (void)
          ESCvar.SM[1].PDIrep = ESCvar.toggle & 0x1U;
          ESC_SMwritepdi (1);
       }
-      return 0;
+      return result;
    }
 
    /* if the outmailbox is free check if we have something to send */
@@ -641,6 +734,16 @@ uint8_t ESC_mbxprocess (void)
       /* outmbx empty and outreq mbx available */
       if (mbxhandle)
       {
+         /* next CNT value between 1-7, in the order sent. Repeats of
+          * this mailbox keep it
+          */
+         ESCvar.mbxcnt++;
+         ESCvar.mbxcnt = (ESCvar.mbxcnt & 0x07);
+         if (ESCvar.mbxcnt == 0)
+         {
+            ESCvar.mbxcnt = 1;
+         }
+         ((_MBXh *)&MBX[mbxhandle * ESC_MBXSIZE])->mbxcnt = ESCvar.mbxcnt & 0xFU;
          ESC_writembx (mbxhandle);
          /* Refresh SM status */
          ESC_SMstatus (1);
@@ -654,9 +757,12 @@ uint8_t ESC_mbxprocess (void)
       }
    }
 
-   /* read mailbox if full and no xoe in progress */
+   /* read mailbox if full and no xoe in progress, while the outbox is
+    * posted only if there is a buffer left for the response
+    */
    if ((ESCvar.SM[0].MBXstat != 0) && (MBXcontrol[0].state == 0)
-         && (ESCvar.mbxoutpost == 0) && (ESCvar.xoe == 0))
+         && ((ESCvar.mbxoutpost == 0) || (ESCvar.mbxidle != 0))
+         && (ESCvar.xoe == 0))
    {
       ESC_readmbx ();
       ESCvar.SM[0].MBXstat = 0;
@@ -675,7 +781,7 @@ uint8_t ESC_mbxprocess (void)
       return 1;
    }
 
-   return 0;
+   return result;
 }
 /** Handler for incorrect or unsupported mailbox data. Write error response
  * in Mailbox.
@@ -811,8 +917,12 @@ uint8_t ESC_startinput (uint8_t state)
    	  /* If inputs > 0 , enable SM3 */
       if (ESCvar.ESC_SM3_sml > 0)
       {
+         ESCvar.txpdovalid = 0;
          ESC_SMenable (3);
       }
+#if USE_TRIPLE_BUFFER
+      APP_discardinputs ();
+#endif
       /* Go to state input regardless of any inputs present */
       CC_ATOMIC_SET(ESCvar.App.state, APPSTATE_INPUT);
    }
@@ -885,6 +995,10 @@ void ESC_stopinput (void)
    CC_ATOMIC_SET(ESCvar.App.state, APPSTATE_IDLE);
    ESC_SMdisable (3);
    ESC_SMdisable (2);
+#if USE_TRIPLE_BUFFER
+   APP_discardinputs ();
+   APP_discardoutputs ();
+#endif
 
    /* Call interrupt disable hook case it have been configured  */
    if ((ESCvar.use_interrupt != 0) &&
@@ -912,6 +1026,9 @@ uint8_t ESC_startoutput (uint8_t state)
    {
       ESC_SMenable (2);
    }
+#if USE_TRIPLE_BUFFER
+   APP_discardoutputs ();
+#endif
    /* Go to state output regardless of any outputs present */
    CC_ATOMIC_OR(ESCvar.App.state, APPSTATE_OUTPUT);
    return state;
@@ -927,6 +1044,9 @@ void ESC_stopoutput (void)
 {
    CC_ATOMIC_AND(ESCvar.App.state, APPSTATE_INPUT);
    ESC_SMdisable (2);
+#if USE_TRIPLE_BUFFER
+   APP_discardoutputs ();
+#endif
    APP_safeoutput ();
 }
 
@@ -1208,6 +1328,7 @@ void ESC_state (void)
       {
          ESCvar.ESC_SM2_sml = sizeOfPDO (RX_PDO_OBJIDX, &ESCvar.sm2mappings,
                                          SMmap2, MAX_MAPPINGS_SM2);
+         ESCvar.rxpdoplanned = 0;
          if (ESCvar.sm2mappings < 0)
          {
             an = ESCpreop | ESCerror;
@@ -1348,6 +1469,9 @@ void ESC_config (esc_cfg_t * cfg)
 
    ESCvar.skip_default_initialization = cfg->skip_default_initialization;
    ESCvar.set_defaults_hook = cfg->set_defaults_hook;
+   ESCvar.default_image = cfg->default_image;
+   ESCvar.default_store = cfg->default_store;
+   ESCvar.default_size = (cfg->default_image != NULL) ? cfg->default_size : 0;
    ESCvar.pre_state_change_hook = cfg->pre_state_change_hook;
    ESCvar.post_state_change_hook = cfg->post_state_change_hook;
    ESCvar.application_hook = cfg->application_hook;
@@ -1357,10 +1481,12 @@ void ESC_config (esc_cfg_t * cfg)
    ESCvar.pre_object_upload_hook = cfg->pre_object_upload_hook;
    ESCvar.post_object_upload_hook = cfg->post_object_upload_hook;
    ESCvar.rxpdo_override = cfg->rxpdo_override;
+   ESCvar.rxpdo_interest = cfg->rxpdo_interest;
    ESCvar.txpdo_override = cfg->txpdo_override;
    ESCvar.esc_hw_interrupt_enable = cfg->esc_hw_interrupt_enable;
    ESCvar.esc_hw_interrupt_disable = cfg->esc_hw_interrupt_disable;
    ESCvar.esc_hw_eep_handler = cfg->esc_hw_eep_handler;
    ESCvar.esc_check_dc_handler = cfg->esc_check_dc_handler;
    ESCvar.get_device_id = cfg->get_device_id;
+   ESCvar.get_timestamp = cfg->get_timestamp;
 }
@@ -48,6 +48,8 @@
 #define ESCREG_SM1                  (ESCREG_SM0 + 0x08)
 #define ESCREG_SM2                  (ESCREG_SM0 + 0x10)
 #define ESCREG_SM3                  (ESCREG_SM0 + 0x18)
+#define ESCREG_SM3STATUS            (ESCREG_SM3 + 5)
+#define ESCREG_SMSTATUS_BUFFER      0x30
 #define ESCREG_LOCALTIME            0x0910
 #define ESCREG_LOCALTIME_OFFSET     0x0920
 #define ESCREG_SYNC_ACT             0x0981
@@ -210,6 +212,9 @@
 #define MBXstate_backup                 0x05
 #define MBXstate_again                  0x06
 
+/* Number of mailbox priorities, _MBXh.priority */
+#define MBXPRIORITIES                   4
+
 #define COE_DEFAULTLENGTH               0x0AU
 #define COE_HEADERSIZE                  0x0AU
 #define COE_SEGMENTHEADERSIZE           0x03U
@@ -284,6 +289,7 @@
 #define FOE_WAIT_FOR_ACK               1
 #define FOE_WAIT_FOR_FINAL_ACK         2
 #define FOE_WAIT_FOR_DATA              3
+#define FOE_WAIT_FOR_BUFFER            4
 
 #define EOE_RESULT_SUCCESS                   0x0000
 #define EOE_RESULT_UNSPECIFIED_ERROR         0x0001
@@ -296,8 +302,6 @@
 #define APPSTATE_INPUT                 0x01
 #define APPSTATE_OUTPUT                0x02
 
-#define PREALLOC_BUFFER_SIZE  (PREALLOC_FACTOR * MBXSIZE)
-
 typedef struct sm_cfg
 {
    uint16_t cfg_sma;
@@ -314,6 +318,12 @@ typedef struct esc_cfg
    int watchdog_cnt;
    bool skip_default_initialization;
    void (*set_defaults_hook) (void);
+   /* Image of the default values of the object storage, copied to
+    * default_store before any object outside of it is initialized
+    */
+   const void * default_image;
+   void * default_store;
+   size_t default_size;
    void (*pre_state_change_hook) (uint8_t * as, uint8_t * an);
    void (*post_state_change_hook) (uint8_t * as, uint8_t * an);
    void (*application_hook) (void);
@@ -335,12 +345,17 @@ typedef struct esc_cfg
          uint8_t subindex,
          uint16_t flags);
    void (*rxpdo_override) (void);
+   /* Return true for the mapped output objects the application consumes,
+    * SM2 is then read partially, see MAX_RXPDO_RANGES
+    */
+   bool (*rxpdo_interest) (uint16_t index, uint8_t subindex);
    void (*txpdo_override) (void);
    void (*esc_hw_interrupt_enable) (uint32_t mask);
    void (*esc_hw_interrupt_disable) (uint32_t mask);
    void (*esc_hw_eep_handler) (void);
    uint16_t (*esc_check_dc_handler) (void);
    int (*get_device_id) (uint16_t * device_id);
+   uint32_t (*get_timestamp) (void);
 } esc_cfg_t;
 
 typedef struct
@@ -439,6 +454,9 @@ typedef struct
    sm_cfg_t  mbboot[2];
    bool skip_default_initialization;
    void (*set_defaults_hook) (void);
+   const void * default_image;
+   void * default_store;
+   size_t default_size;
    void (*pre_state_change_hook) (uint8_t * as, uint8_t * an);
    void (*post_state_change_hook) (uint8_t * as, uint8_t * an);
    void (*application_hook) (void);
@@ -460,18 +478,26 @@ typedef struct
          uint8_t subindex,
          uint16_t flags);
    void (*rxpdo_override) (void);
+   bool (*rxpdo_interest) (uint16_t index, uint8_t subindex);
    void (*txpdo_override) (void);
    void (*esc_hw_interrupt_enable) (uint32_t mask);
    void (*esc_hw_interrupt_disable) (uint32_t mask);
    void (*esc_hw_eep_handler) (void);
    uint16_t (*esc_check_dc_handler) (void);
    int (*get_device_id) (uint16_t * device_id);
+   uint32_t (*get_timestamp) (void);
    uint8_t MBXrun;
    uint32_t activembxsize;
+   uint16_t activembxmin;
+   uint16_t activembxsml[2];
    sm_cfg_t * activemb0;
    sm_cfg_t * activemb1;
    uint16_t ESC_SM2_sml;
    uint16_t ESC_SM3_sml;
+   /* SM2 read plan matches the mapping and the rxpdo_interest hook */
+   uint8_t rxpdoplanned;
+   /* SM3 buffers holding a known image, one bit per buffer */
+   uint8_t txpdovalid;
    uint8_t dcsync;
    uint16_t synccounterlimit;
    uint16_t ALstatus;
@@ -486,7 +512,11 @@ typedef struct
    uint8_t xoe;
    uint8_t txcue;
    uint8_t mbxfree;
+   uint8_t mbxidle;
+   uint8_t mbxqhead[MBXPRIORITIES];
+   uint8_t mbxqtail[MBXPRIORITIES];
    uint8_t segmented;
+   uint8_t segnext;
    void *data;
    uint16_t entries;
    uint32_t frags;
@@ -494,6 +524,10 @@ typedef struct
    uint16_t index;
    uint8_t subindex;
    uint16_t flags;
+   /* Complete Access stream position, next subindex and its bit offset */
+   int32_t canidx;
+   int16_t cansub;
+   uint32_t cabitpos;
 
    uint8_t toggle;
 
@@ -509,7 +543,6 @@ typedef struct
    volatile uint32_t ALevent;
    volatile int8_t synccounter;
    volatile _App App;
-   uint8_t mbxdata[PREALLOC_BUFFER_SIZE];
 } _ESCvar;
 
 CC_PACKED_BEGIN
@@ -630,6 +663,11 @@ typedef struct CC_PACKED
       uint32_t password;
       uint32_t packetnumber;
       uint32_t errorcode;
+      struct
+      {
+         uint16_t done;
+         uint16_t entire;
+      } busy;
    };
 } _FOEh;
 CC_PACKED_END
@@ -677,21 +715,26 @@ CC_PACKED_END
  * 4 : outbox posted not send
  * 5 : backup outbox
  * 6 : mailbox needs to be transmitted again
+ *
+ * Idle outbox buffers are kept on a free list and buffers requested for
+ * posting on one FIFO per mailbox priority, linked through next. Buffer 0
+ * is the inbox and terminates the lists.
  */
 typedef struct
 {
    uint8_t state;
+   uint8_t next;
 } _MBXcontrol;
 
 /* Stack reference to application configuration of the ESC */
 #define ESC_MBXSIZE         (ESCvar.activembxsize)
 #define ESC_MBX0_sma        (ESCvar.activemb0->cfg_sma)
-#define ESC_MBX0_sml        (ESCvar.activemb0->cfg_sml)
-#define ESC_MBX0_sme        (ESCvar.activemb0->cfg_sme)
+#define ESC_MBX0_sml        (ESCvar.activembxsml[0])
+#define ESC_MBX0_sme        ((uint16_t)(ESC_MBX0_sma + ESC_MBX0_sml - 1U))
 #define ESC_MBX0_smc        (ESCvar.activemb0->cfg_smc)
 #define ESC_MBX1_sma        (ESCvar.activemb1->cfg_sma)
-#define ESC_MBX1_sml        (ESCvar.activemb1->cfg_sml)
-#define ESC_MBX1_sme        (ESCvar.activemb1->cfg_sme)
+#define ESC_MBX1_sml        (ESCvar.activembxsml[1])
+#define ESC_MBX1_sme        ((uint16_t)(ESC_MBX1_sma + ESC_MBX1_sml - 1U))
 #define ESC_MBX1_smc        (ESCvar.activemb1->cfg_smc)
 #define ESC_MBXBUFFERS      (MBXBUFFERS)
 #define ESC_SM2_sma         (SM2_sma)
@@ -702,11 +745,14 @@ typedef struct
 #define ESC_SM3_act         (SM3_act)
 
 #define ESC_MBXHSIZE        ((uint32_t)sizeof(_MBXh))
-#define ESC_MBXDSIZE        (ESC_MBXSIZE - ESC_MBXHSIZE)
+/* Data sizes of outbox mailboxes, sent to the master */
+#define ESC_MBXDSIZE        (ESC_MBX1_sml - ESC_MBXHSIZE)
 #define ESC_FOEHSIZE        (uint32_t)sizeof(_FOEh)
-#define ESC_FOE_DATA_SIZE   (ESC_MBXSIZE - (ESC_MBXHSIZE +ESC_FOEHSIZE))
+#define ESC_FOE_DATA_SIZE   (ESC_MBX1_sml - (ESC_MBXHSIZE +ESC_FOEHSIZE))
+/* FoE data size of inbox mailboxes, received from the master */
+#define ESC_FOE_DATA_SIZE_RX (ESC_MBX0_sml - (ESC_MBXHSIZE +ESC_FOEHSIZE))
 #define ESC_EOEHSIZE        ((uint32_t)sizeof(_EOEh))
-#define ESC_EOE_DATA_SIZE   (ESC_MBXSIZE - (ESC_MBXHSIZE +ESC_EOEHSIZE))
+#define ESC_EOE_DATA_SIZE   (ESC_MBX1_sml - (ESC_MBXHSIZE +ESC_EOEHSIZE))
 
 void ESC_config (esc_cfg_t * cfg);
 void ESC_ALerror (uint16_t errornumber);
@@ -719,6 +765,8 @@ void ESC_ALstatusgotoerror (uint8_t status, uint16_t errornumber);
 void ESC_SMstatus (uint8_t n);
 uint8_t ESC_WDstatus (void);
 uint8_t ESC_claimbuffer (void);
+void ESC_releasebuffer (uint8_t n);
+void ESC_mbxpost (uint8_t n);
 uint8_t ESC_startmbx (uint8_t state);
 void ESC_stopmbx (void);
 void MBX_error (uint16_t error);
@@ -739,6 +787,10 @@ void ESC_reset (void);
 
 /* From application */
 extern void APP_safeoutput ();
+#if USE_TRIPLE_BUFFER
+extern void APP_discardoutputs (void);
+extern void APP_discardinputs (void);
+#endif
 extern _ESCvar ESCvar;
 extern _MBXcontrol MBXcontrol[];
 extern uint8_t MBX[];
@@ -15,12 +15,18 @@
 #include <stdbool.h>
 #include <string.h>
 #include <cc.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "esc.h"
 #include "esc_coe.h"
 
 #define BITS2BYTES(b) ((b + 7U) >> 3)
 #define BITSPOS2BYTESOFFSET(b) (b >> 3)
 
+/* Shortest run of 1-bit objects packed and unpacked as a whole */
+#define BITRUN_MIN 8
+
 /* Fetch value from object dictionary */
 #define OBJ_VALUE_FETCH(v, o) \
    ((o).data ? *(__typeof__ (v) *)(o).data : (__typeof__ (v))(o).value)
@@ -75,23 +81,220 @@ int16_t SDO_findsubindex (int32_t nidx, uint8_t subindex)
    return n;
 }
 
+/** Get the number of objects in the Object List, not counting the
+ * terminating 0xffff entry. The list is counted on first use.
+ *
+ * @return number of objects
+ */
+static uint16_t SDO_objectcount (void)
+{
+   static uint16_t count;
+
+   if (count == 0)
+   {
+      uint16_t n = 0;
+
+      while (SDOobjects[n].index != 0xffff)
+      {
+         n++;
+      }
+      count = n;
+   }
+   return count;
+}
+
 /** Search for an object index matching the wanted value in the Object List.
+ * The Object List must be sorted on index.
  *
  * @param[in] index   = value on index of object we want to locate
  * @return local array index if we succeed, -1 if we didn't find the index.
  */
 int32_t SDO_findobject (uint16_t index)
 {
-   int32_t n = 0;
-   while (SDOobjects[n].index < index)
+   int32_t low = 0;
+   int32_t high = (int32_t)SDO_objectcount () - 1;
+
+   while (low <= high)
    {
-      n++;
+      int32_t n = low + ((high - low) >> 1);
+
+      if (SDOobjects[n].index < index)
+      {
+         low = n + 1;
+      }
+      else if (SDOobjects[n].index > index)
+      {
+         high = n - 1;
+      }
+      else
+      {
+         return n;
+      }
    }
-   if (SDOobjects[n].index != index)
+   return -1;
+}
+
+/** Get the size of the storage used for a datatype.
+ *
+ * @param[in] datatype = object datatype
+ * @return size of storage in bytes, 0 if datatype has no fixed size storage
+ */
+static uint16_t COE_dataSize (uint16_t datatype)
+{
+   switch(datatype)
    {
-      return -1;
+   case DTYPE_BIT1:
+   case DTYPE_BIT2:
+   case DTYPE_BIT3:
+   case DTYPE_BIT4:
+   case DTYPE_BIT5:
+   case DTYPE_BIT6:
+   case DTYPE_BIT7:
+   case DTYPE_BIT8:
+   case DTYPE_BOOLEAN:
+   case DTYPE_UNSIGNED8:
+   case DTYPE_INTEGER8:
+   case DTYPE_BITARR8:
+      return 1;
+
+   case DTYPE_UNSIGNED16:
+   case DTYPE_INTEGER16:
+   case DTYPE_BITARR16:
+      return 2;
+
+   case DTYPE_REAL32:
+   case DTYPE_UNSIGNED32:
+   case DTYPE_INTEGER32:
+   case DTYPE_BITARR32:
+      return 4;
+
+   case DTYPE_REAL64:
+   case DTYPE_UNSIGNED64:
+   case DTYPE_INTEGER64:
+      return 8;
+
+   default:
+      return 0;
+   }
+}
+
+/** Compile the copy plan for a list of mapped objects.
+ *
+ * Byte aligned objects whose storage matches the process data
+ * representation are copied with memcpy. Runs of such objects that
+ * are consecutive both in the process data and in memory are merged
+ * into a single copy. Runs of at least BITRUN_MIN 1-bit objects stored
+ * in consecutive bytes are likewise merged into one bit run, packed
+ * and unpacked several bits at a time. Remaining objects of known size
+ * are bit packed using the storage size resolved here, others are left
+ * to the generic per-object handling.
+ *
+ * @param[in,out] mappings = list of mapped objects in SM
+ * @param[in] nmappings    = number of mapped objects in SM
+ */
+void COE_pdoPlan (_SMmap * mappings, int nmappings)
+{
+   _SMmap * copy = NULL;
+   int ix;
+
+   for (ix = 0; ix < nmappings; ix++)
+   {
+      _SMmap * mapping = &mappings[ix];
+      const _objd * obj = mapping->obj;
+      uint16_t size;
+      bool native;
+
+      mapping->data = NULL;
+      mapping->length = 0;
+      mapping->span = 1;
+      mapping->op = SMMAP_OP_NONE;
+
+      if ((obj == NULL) || (obj->data == NULL))
+      {
+         copy = NULL;
+         continue;
+      }
+
+      size = COE_dataSize (obj->datatype);
+#if defined(EC_LITTLE_ENDIAN)
+      native = (size != 0) && (size * 8U == obj->bitlength);
+#else
+      native = false;
+#endif
+
+#if defined(EC_LITTLE_ENDIAN)
+      if ((size == 1) && (obj->bitlength == 1))
+      {
+         int count = 1;
+
+         while ((ix + count < nmappings) && (count < UINT16_MAX))
+         {
+            const _SMmap * prev = &mappings[ix + count - 1];
+            const _objd * next = mappings[ix + count].obj;
+
+            if ((next == NULL) || (next->data == NULL) ||
+                (next->bitlength != 1) ||
+                (COE_dataSize (next->datatype) != 1) ||
+                (mappings[ix + count].offset != prev->offset + 1) ||
+                (next->data != (uint8_t *)prev->obj->data + 1))
+            {
+               break;
+            }
+            count++;
+         }
+
+         if (count >= BITRUN_MIN)
+         {
+            int n;
+
+            mapping->op = SMMAP_OP_BITRUN;
+            mapping->data = obj->data;
+            mapping->length = (uint16_t)count;
+            mapping->span = (uint16_t)count;
+            for (n = 1; n < count; n++)
+            {
+               mappings[ix + n].data = NULL;
+               mappings[ix + n].length = 0;
+               mappings[ix + n].span = 1;
+               mappings[ix + n].op = SMMAP_OP_NONE;
+            }
+            ix += count - 1;
+            copy = NULL;
+            continue;
+         }
+      }
+#endif
+
+      if ((mapping->offset % 8U == 0) && ((obj->bitlength > 64) || native))
+      {
+         uint16_t length = (uint16_t)BITS2BYTES (obj->bitlength);
+
+         if ((copy != NULL) &&
+             (copy->offset + copy->length * 8U == mapping->offset) &&
+             ((uint8_t *)copy->data + copy->length == obj->data) &&
+             (copy->length + length <= UINT16_MAX))
+         {
+            copy->length = (uint16_t)(copy->length + length);
+            copy->span++;
+            continue;
+         }
+
+         mapping->op = SMMAP_OP_COPY;
+         mapping->data = obj->data;
+         mapping->length = length;
+         copy = mapping;
+      }
+      else
+      {
+         if ((size != 0) && (obj->bitlength <= 64))
+         {
+            mapping->op = SMMAP_OP_BITS;
+            mapping->data = obj->data;
+            mapping->length = size;
+         }
+         copy = NULL;
+      }
    }
-   return n;
 }
 
 /**
@@ -228,6 +431,7 @@ uint16_t sizeOfPDO (uint16_t index, int * nmappings, _SMmap * mappings,
    if (max_mappings > 0)
    {
       *nmappings = mapIx;
+      COE_pdoPlan (mappings, mapIx);
    }
    else
    {
@@ -274,7 +478,7 @@ static void SDO_abort (uint8_t reusembx, uint16_t index, uint8_t subindex, uint3
       coeres->subindex = subindex;
       coeres->command = COE_COMMAND_SDOABORT;
       coeres->size = htoel (abortcode);
-      MBXcontrol[MBXout].state = MBXstate_outreq;
+      ESC_mbxpost (MBXout);
    }
 }
 
@@ -292,6 +496,260 @@ static void set_state_idle (uint8_t reusembx,
    ESCvar.xoe = 0;
 }
 
+static uint32_t complete_access_get_variables(_COEsdo *coesdo, uint16_t *index,
+                                              uint8_t *subindex, int32_t *nidx,
+                                              int16_t *nsub)
+{
+   *index = etohs (coesdo->index);
+   *subindex = coesdo->subindex;
+
+   /* A Complete Access must start with Subindex 0 or Subindex 1 */
+   if (*subindex > 1)
+   {
+      return ABORT_UNSUPPORTED;
+   }
+
+   *nidx = SDO_findobject (*index);
+   if (*nidx < 0)
+   {
+      return ABORT_NOOBJECT;
+   }
+
+   *nsub = SDO_findsubindex (*nidx, *subindex);
+   if (*nsub < 0)
+   {
+      return ABORT_NOSUBINDEX;
+   }
+
+   return 0;
+}
+
+/** Get the size of the data of a Complete Access, from subindex nsub up to
+ *  the highest subindex.
+ *
+ * @param[in] nidx     = object index in SDOobjects
+ * @param[in] nsub     = first subindex position in the object description
+ * @param[out] bytes   = size in bytes
+ * @return 0 or an abort code if the object can't be accessed
+ */
+static uint32_t complete_access_size(int32_t nidx,
+                                     int16_t nsub,
+                                     uint32_t *bytes)
+{
+   const _objd *objd = SDOobjects[nidx].objdesc;
+   uint32_t size = 0;
+
+   /* Objects with dynamic entries cannot be accessed with Complete Access */
+   if ((objd->datatype == DTYPE_VISIBLE_STRING) ||
+       (objd->datatype == DTYPE_OCTET_STRING)   ||
+       (objd->datatype == DTYPE_UNICODE_STRING))
+   {
+      return ABORT_CA_NOT_SUPPORTED;
+   }
+
+   while (nsub <= SDOobjects[nidx].maxsub)
+   {
+      uint16_t bitlen = (objd + nsub)->bitlength;
+
+      if (((bitlen % 8) == 0) && ((size % 8) != 0))
+      {
+         /* move on to next byte boundary */
+         size += (8U - (size % 8));
+      }
+      /* Subindex 0 is padded to 16 bit if not object type VARIABLE.
+       * For VARIABLE use true bitsize.
+       */
+      size +=
+      ((nsub == 0) && (SDOobjects[nidx].objtype != OTYPE_VAR)) ? 16 : bitlen;
+      nsub++;
+   }
+
+   *bytes = BITS2BYTES(size);
+   return 0;
+}
+
+/** Start streaming the data of a Complete Access.
+ *
+ * @param[in] nidx     = object index in SDOobjects
+ * @param[in] nsub     = first subindex position in the object description
+ */
+static void complete_access_start(int32_t nidx, int16_t nsub)
+{
+   ESCvar.canidx = nidx;
+   ESCvar.cansub = nsub;
+   ESCvar.cabitpos = 0;
+}
+
+/** Copy a window of the data of a Complete Access between the subindexes
+ *  and a mailbox, so data of any size can be streamed segment by segment.
+ *  The subindexes are visited from the position where the previous window
+ *  ended, so windows must follow each other from offset 0. Padding and
+ *  subindexes that can't be read are uploaded as zeroes, subindexes that
+ *  can't be written are skipped on download.
+ *
+ * @param[in] buf        = mailbox data of the window
+ * @param[in] offset     = byte offset of the window in the data
+ * @param[in] length     = window length in bytes
+ * @param[in] load_type  = UPLOAD to copy from the subindexes, DOWNLOAD to
+ *                         copy to them
+ */
+static void complete_access_stream(uint8_t *buf,
+                                   uint32_t offset,
+                                   uint32_t length,
+                                   load_t load_type)
+{
+   const _objd *objd = SDOobjects[ESCvar.canidx].objdesc;
+   int16_t nsub = ESCvar.cansub;
+   uint32_t size = ESCvar.cabitpos;
+   uint32_t end = offset + length;
+   uint8_t state = ESCvar.ALstatus & 0x0f;
+
+   if (load_type == UPLOAD)
+   {
+      memset(buf, 0, length);
+   }
+
+   while (nsub <= SDOobjects[ESCvar.canidx].maxsub)
+   {
+      uint16_t bitlen = (objd + nsub)->bitlength;
+      uint8_t *data = ((objd + nsub)->data != NULL) ?
+            (objd + nsub)->data : (uint8_t *)&((objd + nsub)->value);
+      uint8_t access = (objd + nsub)->flags & 0x3f;
+      uint32_t start;
+
+      if (((bitlen % 8) == 0) && ((size % 8) != 0))
+      {
+         /* move on to next byte boundary */
+         size += (8U - (size % 8));
+      }
+      start = BITSPOS2BYTESOFFSET(size);
+      if (start >= end)
+      {
+         break;
+      }
+
+      if ((bitlen % 8) == 0)
+      {
+         /* copy the part of a non-bit data type inside the window */
+         uint32_t entryend = start + BITS2BYTES(bitlen);
+         uint32_t from = MAX(start, offset);
+         uint32_t to = MIN(entryend, end);
+
+         if (load_type == UPLOAD)
+         {
+            if (READ_ACCESS(access, state))
+            {
+               memcpy(&buf[from - offset], &data[from - start], to - from);
+            }
+         }
+         /* download of RO objects shall be ignored */
+         else if (WRITE_ACCESS(access, state) && ((objd + nsub)->data != NULL))
+         {
+            memcpy(&data[from - start], &buf[from - offset], to - from);
+         }
+         if (entryend > end)
+         {
+            /* continue in the next window */
+            break;
+         }
+      }
+      else if ((load_type == UPLOAD) && READ_ACCESS(access, state))
+      {
+         /* copy a bit data type into correct position */
+         uint32_t bitmask = (1U << bitlen) - 1U;
+         uint32_t tempmask = (*data & bitmask) << (size % 8);
+         buf[start - offset] |= (uint8_t)tempmask;
+      }
+
+      /* Subindex 0 is padded to 16 bit if not object type VARIABLE.
+       * For VARIABLE use true bitsize.
+       */
+      size += ((nsub == 0) &&
+               (SDOobjects[ESCvar.canidx].objtype != OTYPE_VAR)) ? 16 : bitlen;
+      nsub++;
+   }
+
+   ESCvar.cansub = nsub;
+   ESCvar.cabitpos = size;
+}
+
+static void init_coesdo(_COEsdo *coesdo,
+                        uint8_t sdoservice,
+                        uint8_t command,
+                        uint16_t index,
+                        uint8_t subindex)
+{
+   coesdo->mbxheader.length = htoes(COE_DEFAULTLENGTH);
+   coesdo->mbxheader.mbxtype = MBXCOE;
+   coesdo->coeheader.numberservice = htoes(sdoservice << 12);
+   coesdo->command = command;
+   coesdo->index = htoes(index);
+   coesdo->subindex = subindex;
+}
+
+/** Build the next segment of a segmented SDO Upload in a claimed Mailbox
+ *  buffer. The toggle bit is set from the request when it is posted.
+ *
+ * @param[in] MBXout = mailbox buffer to build the segment in
+ */
+static void SDO_buildsegment (uint8_t MBXout)
+{
+   _COEsdo *coeres;
+   uint32_t size, offset;
+   coeres = (_COEsdo *) &MBX[MBXout * ESC_MBXSIZE];
+   offset = ESCvar.fragsleft;
+   size = ESCvar.frags - ESCvar.fragsleft;
+   init_coesdo(coeres, COE_SDORESPONSE, COE_COMMAND_UPLOADSEGMENT, 0, 0);
+   if ((size + COE_SEGMENTHEADERSIZE) > ESC_MBXDSIZE)
+   {
+      /* more segmented transfer needed */
+      /* limit to mailbox size */
+      size = ESC_MBXDSIZE - COE_SEGMENTHEADERSIZE;
+      coeres->mbxheader.length = htoes (COE_SEGMENTHEADERSIZE + size);
+   }
+   else
+   {
+      /* last segment */
+      coeres->command |= COE_COMMAND_LASTSEGMENTBIT;
+      if (size >= 7)
+      {
+         coeres->mbxheader.length = htoes (COE_SEGMENTHEADERSIZE + size);
+      }
+      else
+      {
+         coeres->command |= (uint8_t)((7U - size) << 1);
+         coeres->mbxheader.length = htoes (COE_DEFAULTLENGTH);
+      }
+   }
+   /* number of bytes done */
+   ESCvar.fragsleft += size;
+   if (ESCvar.flags == COMPLETE_ACCESS_FLAG)
+   {
+      complete_access_stream ((&(coeres->command)) + 1, offset, size, UPLOAD);
+   }
+   else
+   {
+      copy2mbx ((uint8_t *) ESCvar.data + offset, (&(coeres->command)) + 1,
+            size);        /* copy to mailbox */
+   }
+}
+
+/** Claim a Mailbox buffer and build the next segment of a segmented SDO
+ *  Upload in it, so the segment is ready to be posted when requested while
+ *  the previous one is sent. Nothing is done if no buffer is available.
+ */
+static void SDO_prepsegment (void)
+{
+   if ((ESCvar.segnext == 0) && (ESCvar.fragsleft < ESCvar.frags))
+   {
+      ESCvar.segnext = ESC_claimbuffer ();
+      if (ESCvar.segnext)
+      {
+         SDO_buildsegment (ESCvar.segnext);
+      }
+   }
+}
+
 /** Function for responding on requested SDO Upload, sending the content
  *  requested in a free Mailbox buffer. Depending of size of data expedited,
  *  normal or segmented transfer is used. On error an SDO Abort will be sent.
@@ -402,6 +860,10 @@ static void SDO_upload (void)
                      ESCvar.segmented = MBXSEU;
                      ESCvar.data = (objd + nsub)->data;
                      ESCvar.flags = (objd + nsub)->flags;
+                     ESCvar.index = index;
+                     ESCvar.subindex = subindex;
+                     /* prepare the next segment while this one is sent */
+                     SDO_prepsegment ();
                   }
                   else
                   {
@@ -418,172 +880,30 @@ static void SDO_upload (void)
                   return;
                }
             }
-            if ((abort == 0) && (ESCvar.segmented == 0))
-            {
-               abort = ESC_upload_post_objecthandler (index, subindex,
-                                                      (objd + nsub)->flags);
-               if (abort != 0)
-               {
-                  set_state_idle (MBXout, index, subindex, abort);
-                  return;
-               }
-            }
-            MBXcontrol[MBXout].state = MBXstate_outreq;
-         }
-      }
-      else
-      {
-         SDO_abort (0, index, subindex, ABORT_NOSUBINDEX);
-      }
-   }
-   else
-   {
-      SDO_abort (0, index, subindex, ABORT_NOOBJECT);
-   }
-   MBXcontrol[0].state = MBXstate_idle;
-   ESCvar.xoe = 0;
-}
-
-static uint32_t complete_access_get_variables(_COEsdo *coesdo, uint16_t *index,
-                                              uint8_t *subindex, int32_t *nidx,
-                                              int16_t *nsub)
-{
-   *index = etohs (coesdo->index);
-   *subindex = coesdo->subindex;
-
-   /* A Complete Access must start with Subindex 0 or Subindex 1 */
-   if (*subindex > 1)
-   {
-      return ABORT_UNSUPPORTED;
-   }
-
-   *nidx = SDO_findobject (*index);
-   if (*nidx < 0)
-   {
-      return ABORT_NOOBJECT;
-   }
-
-   *nsub = SDO_findsubindex (*nidx, *subindex);
-   if (*nsub < 0)
-   {
-      return ABORT_NOSUBINDEX;
-   }
-
-   return 0;
-}
-
-static uint32_t complete_access_subindex_loop(const _objd *objd,
-                                              int32_t nidx,
-                                              int16_t nsub,
-                                              uint8_t *mbxdata,
-                                              load_t load_type,
-                                              uint32_t max_bytes)
-{
-   /* Objects with dynamic entries cannot be accessed with Complete Access */
-   if ((objd->datatype == DTYPE_VISIBLE_STRING) ||
-       (objd->datatype == DTYPE_OCTET_STRING)   ||
-       (objd->datatype == DTYPE_UNICODE_STRING))
-   {
-      return ABORT_CA_NOT_SUPPORTED;
-   }
-
-   uint32_t size = 0;
-
-   /* Clear padded mbxdata byte [1] on upload */
-   if ((load_type == UPLOAD) && (mbxdata != NULL))
-   {
-      mbxdata[1] = 0;
-   }
-
-   while (nsub <= SDOobjects[nidx].maxsub)
-   {
-      uint16_t bitlen = (objd + nsub)->bitlength;
-      void *ul_source = ((objd + nsub)->data != NULL) ?
-            (objd + nsub)->data : (void *)&((objd + nsub)->value);
-      uint8_t bitoffset = size % 8;
-      uint8_t access = (objd + nsub)->flags & 0x3f;
-      uint8_t state = ESCvar.ALstatus & 0x0f;
-
-      if ((bitlen % 8) == 0)
-      {
-         if (bitoffset != 0)
-         {
-            /* move on to next byte boundary */
-            size += (8U - bitoffset);
-         }
-         if (mbxdata != NULL)
-         {
-            /* copy a non-bit data type to a byte boundary */
-            if (load_type == UPLOAD)
-            {
-               if (READ_ACCESS(access, state))
-               {
-                  memcpy(&mbxdata[BITS2BYTES(size)], ul_source,
-                        BITS2BYTES(bitlen));
-               }
-               else
-               {
-                  /* return zeroes for upload of WO objects */
-                  memset(&mbxdata[BITS2BYTES(size)], 0, BITS2BYTES(bitlen));
-               }
-            }
-            /* download of RO objects shall be ignored */
-            else if (WRITE_ACCESS(access, state))
-            {
-               memcpy((objd + nsub)->data, &mbxdata[BITS2BYTES(size)],
-                     BITS2BYTES(bitlen));
-            }
-         }
-      }
-      else if ((load_type == UPLOAD) && (mbxdata != NULL))
-      {
-         /* copy a bit data type into correct position */
-         uint32_t bitmask = (1U << bitlen) - 1U;
-         uint32_t tempmask;
-         if (READ_ACCESS(access, state))
-         {
-            if (bitoffset == 0)
+            if ((abort == 0) && (ESCvar.segmented == 0))
             {
-               mbxdata[BITSPOS2BYTESOFFSET(size)] = 0;
+               abort = ESC_upload_post_objecthandler (index, subindex,
+                                                      (objd + nsub)->flags);
+               if (abort != 0)
+               {
+                  set_state_idle (MBXout, index, subindex, abort);
+                  return;
+               }
             }
-            tempmask = (*(uint8_t *)ul_source & bitmask) << bitoffset;
-            mbxdata[BITSPOS2BYTESOFFSET(size)] |= (uint8_t)tempmask;
-         }
-         else
-         {
-            tempmask = ~(bitmask << bitoffset);
-            mbxdata[BITSPOS2BYTESOFFSET(size)] &= (uint8_t)tempmask;
+            ESC_mbxpost (MBXout);
          }
       }
-
-      /* Subindex 0 is padded to 16 bit if not object type VARIABLE.
-       * For VARIABLE use true bitsize.
-       */
-      size +=
-      ((nsub == 0) && (SDOobjects[nidx].objtype != OTYPE_VAR)) ? 16 : bitlen;
-      nsub++;
-
-      if ((max_bytes > 0) && (BITS2BYTES(size) >= max_bytes))
+      else
       {
-         break;
+         SDO_abort (0, index, subindex, ABORT_NOSUBINDEX);
       }
    }
-
-   return size;
-}
-
-static void init_coesdo(_COEsdo *coesdo,
-                        uint8_t sdoservice,
-                        uint8_t command,
-                        uint16_t index,
-                        uint8_t subindex)
-{
-   coesdo->mbxheader.length = htoes(COE_DEFAULTLENGTH);
-   coesdo->mbxheader.mbxtype = MBXCOE;
-   coesdo->coeheader.numberservice = htoes(sdoservice << 12);
-   coesdo->command = command;
-   coesdo->index = htoes(index);
-   coesdo->subindex = subindex;
+   else
+   {
+      SDO_abort (0, index, subindex, ABORT_NOOBJECT);
+   }
+   MBXcontrol[0].state = MBXstate_idle;
+   ESCvar.xoe = 0;
 }
 
 /** Function for responding on requested SDO Upload with Complete Access,
@@ -619,27 +939,14 @@ static void SDO_upload_complete_access (void)
    const _objd *objd = SDOobjects[nidx].objdesc;
 
    /* loop through the subindexes to get the total size */
-   uint32_t size = complete_access_subindex_loop(objd, nidx, nsub, NULL, UPLOAD, 0);
-
-   /* expedited bits used calculation */
-   uint8_t dss = (size > 24) ? 0 : (uint8_t)(4U * (3U - ((size - 1U) >> 3)));
-
-   /* convert bits to bytes */
-   size = BITS2BYTES(size);
-
-   if (size > 0xffff)
+   uint32_t size;
+   abortcode = complete_access_size(nidx, nsub, &size);
+   if (abortcode != 0)
    {
-      /* 'size' is in this case actually an abort code */
-      set_state_idle (MBXout, index, subindex, size);
+      set_state_idle (MBXout, index, subindex, abortcode);
       return;
    }
 
-   /* check that upload data fits in the preallocated buffer */
-   if ((size + PREALLOC_FACTOR * COE_HEADERSIZE) > PREALLOC_BUFFER_SIZE)
-   {
-      set_state_idle (MBXout, index, subindex, ABORT_CA_NOT_SUPPORTED);
-      return;
-   }
    abortcode = ESC_upload_pre_objecthandler(index, subindex,
          objd->data, (size_t *)&size, objd->flags | COMPLETE_ACCESS_FLAG);
    if (abortcode != 0)
@@ -648,21 +955,19 @@ static void SDO_upload_complete_access (void)
       return;
    }
 
-   /* copy subindex data into the preallocated buffer */
-   complete_access_subindex_loop(objd, nidx, nsub, ESCvar.mbxdata, UPLOAD, 0);
-
    _COEsdo *coeres = (_COEsdo *) &MBX[MBXout * ESC_MBXSIZE];
    init_coesdo(coeres, COE_SDORESPONSE,
          COE_COMMAND_UPLOADRESPONSE | COE_COMPLETEACCESS | COE_SIZE_INDICATOR,
          index, subindex);
 
    ESCvar.segmented = 0;
+   complete_access_start(nidx, nsub);
 
    if (size <= 4)
    {
       /* expedited response, i.e. length <= 4 bytes */
-      coeres->command |= (COE_EXPEDITED_INDICATOR | dss);
-      memcpy(&(coeres->size), ESCvar.mbxdata, size);
+      coeres->command |= (uint8_t)(COE_EXPEDITED_INDICATOR | (4U * (4U - size)));
+      complete_access_stream((uint8_t *)&(coeres->size), 0, size, UPLOAD);
    }
    else
    {
@@ -680,12 +985,19 @@ static void SDO_upload_complete_access (void)
          ESCvar.fragsleft = size;
          /* signal segmented transfer */
          ESCvar.segmented = MBXSEU;
-         ESCvar.data = ESCvar.mbxdata;
          ESCvar.flags = COMPLETE_ACCESS_FLAG;
+         ESCvar.index = index;
+         ESCvar.subindex = subindex;
       }
 
       coeres->mbxheader.length = htoes (COE_HEADERSIZE + size);
-      memcpy((&(coeres->size)) + 1, ESCvar.mbxdata, size);
+      complete_access_stream((uint8_t *)((&(coeres->size)) + 1), 0, size,
+            UPLOAD);
+      if (ESCvar.segmented == MBXSEU)
+      {
+         /* prepare the next segment while this one is sent */
+         SDO_prepsegment ();
+      }
    }
 
    if (ESCvar.segmented == 0)
@@ -700,7 +1012,7 @@ static void SDO_upload_complete_access (void)
       }
    }
 
-   MBXcontrol[MBXout].state = MBXstate_outreq;
+   ESC_mbxpost (MBXout);
 
    set_state_idle (MBXout, index, subindex, 0);
 }
@@ -712,59 +1024,41 @@ static void SDO_uploadsegment (void)
 {
    _COEsdo *coesdo, *coeres;
    uint8_t MBXout;
-   uint32_t size, offset, abort;
+   uint32_t abort;
    coesdo = (_COEsdo *) &MBX[0];
-   MBXout = ESC_claimbuffer ();
-   if (MBXout)
+   /* use the segment prepared in advance if any */
+   MBXout = ESCvar.segnext;
+   ESCvar.segnext = 0;
+   if (MBXout == 0)
    {
-      coeres = (_COEsdo *) &MBX[MBXout * ESC_MBXSIZE];
-      offset = ESCvar.fragsleft;
-      size = ESCvar.frags - ESCvar.fragsleft;
-      uint8_t command = COE_COMMAND_UPLOADSEGMENT |
-            (coesdo->command & COE_TOGGLEBIT);  /* copy toggle bit */
-      init_coesdo(coeres, COE_SDORESPONSE, command,
-            coesdo->index, coesdo->subindex);
-      if ((size + COE_SEGMENTHEADERSIZE) > ESC_MBXDSIZE)
+      MBXout = ESC_claimbuffer ();
+      if (MBXout)
       {
-         /* more segmented transfer needed */
-         /* limit to mailbox size */
-         size = ESC_MBXDSIZE - COE_SEGMENTHEADERSIZE;
-         /* number of bytes done */
-         ESCvar.fragsleft += size;
-         coeres->mbxheader.length = htoes (COE_SEGMENTHEADERSIZE + size);
+         SDO_buildsegment (MBXout);
       }
-      else
+   }
+   if (MBXout)
+   {
+      coeres = (_COEsdo *) &MBX[MBXout * ESC_MBXSIZE];
+      coeres->command |= (coesdo->command & COE_TOGGLEBIT);  /* copy toggle bit */
+
+      if (ESCvar.fragsleft >= ESCvar.frags)
       {
          /* last segment */
          ESCvar.segmented = 0;
          ESCvar.frags = 0;
          ESCvar.fragsleft = 0;
-         coeres->command |= COE_COMMAND_LASTSEGMENTBIT;
-         if (size >= 7)
-         {
-            coeres->mbxheader.length = htoes (COE_SEGMENTHEADERSIZE + size);
-         }
-         else
-         {
-            coeres->command |= (uint8_t)((7U - size) << 1);
-            coeres->mbxheader.length = htoes (COE_DEFAULTLENGTH);
-         }
-      }
-      copy2mbx ((uint8_t *) ESCvar.data + offset, (&(coeres->command)) + 1,
-            size);        /* copy to mailbox */
-
-      if (ESCvar.segmented == 0)
-      {
-         abort = ESC_upload_post_objecthandler (etohs (coesdo->index),
-               coesdo->subindex, ESCvar.flags);
+         abort = ESC_upload_post_objecthandler (ESCvar.index,
+               ESCvar.subindex, ESCvar.flags);
          if (abort != 0)
          {
-            set_state_idle (MBXout, etohs (coesdo->index), coesdo->subindex, abort);
+            set_state_idle (MBXout, ESCvar.index, ESCvar.subindex, abort);
             return;
          }
       }
 
-      MBXcontrol[MBXout].state = MBXstate_outreq;
+      ESC_mbxpost (MBXout);
+      SDO_prepsegment ();
    }
    MBXcontrol[0].state = MBXstate_idle;
    ESCvar.xoe = 0;
@@ -874,7 +1168,7 @@ static void SDO_download (void)
                   coeres->subindex = subindex;
                   coeres->command = COE_COMMAND_DOWNLOADRESPONSE;
                   coeres->size = htoel (0);
-                  MBXcontrol[MBXout].state = MBXstate_outreq;
+                  ESC_mbxpost (MBXout);
                }
                if (ESCvar.segmented == 0)
                {
@@ -954,12 +1248,11 @@ static void SDO_download_complete_access (void)
    const _objd *objd = SDOobjects[nidx].objdesc;
 
    /* loop through the subindexes to get the total size */
-   uint32_t size = complete_access_subindex_loop(objd, nidx, nsub, NULL, DOWNLOAD, 0);
-   size = BITS2BYTES(size);
-   if (size > 0xffff)
+   uint32_t size;
+   abortcode = complete_access_size(nidx, nsub, &size);
+   if (abortcode != 0)
    {
-      /* 'size' is in this case actually an abort code */
-      set_state_idle (0, index, subindex, size);
+      set_state_idle (0, index, subindex, abortcode);
       return;
    }
    /* The document ETG.1020 S (R) V1.3.0, chapter 12.2, states that
@@ -978,33 +1271,29 @@ static void SDO_download_complete_access (void)
          return;
       }
 
-      if ((bytes + COE_HEADERSIZE) > ESC_MBXDSIZE)
+      complete_access_start(nidx, nsub);
+      /* download data in this mailbox */
+      size = etohs (coesdo->mbxheader.length) - COE_HEADERSIZE;
+      if (((coesdo->command & COE_EXPEDITED_INDICATOR) == 0) && (bytes > size))
       {
-         /* check that download data fits in the preallocated buffer */
-         if ((bytes + PREALLOC_FACTOR * COE_HEADERSIZE) > PREALLOC_BUFFER_SIZE)
-         {
-             set_state_idle(0, index, subindex, ABORT_CA_NOT_SUPPORTED);
-             return;
-         }
          /* set total size in bytes */
          ESCvar.frags = bytes;
-         /* limit to mailbox size */
-         size = ESC_MBXDSIZE - COE_HEADERSIZE;
          /* number of bytes done */
          ESCvar.fragsleft = size;
          ESCvar.segmented = MBXSED;
-         ESCvar.data = ESCvar.mbxdata + size;
          ESCvar.index = index;
          ESCvar.subindex = subindex;
          ESCvar.flags = COMPLETE_ACCESS_FLAG;
-         /* Store the data */
-         copy2mbx (mbxdata, ESCvar.mbxdata, size);
+         /* copy the first segment of download data to subindexes, an abort
+          * in a later segment does not undo it, see SDO_downloadsegment
+          */
+         complete_access_stream((uint8_t *)mbxdata, 0, size, DOWNLOAD);
       }
       else
       {
          ESCvar.segmented = 0;
          /* copy download data to subindexes */
-         complete_access_subindex_loop(objd, nidx, nsub, (uint8_t *)mbxdata, DOWNLOAD, bytes);
+         complete_access_stream((uint8_t *)mbxdata, 0, bytes, DOWNLOAD);
 
          abortcode = ESC_download_post_objecthandler(index, subindex,
                objd->flags | COMPLETE_ACCESS_FLAG);
@@ -1030,7 +1319,7 @@ static void SDO_download_complete_access (void)
                   index, subindex);
 
       coeres->size = 0;
-      MBXcontrol[MBXout].state = MBXstate_outreq;
+      ESC_mbxpost (MBXout);
    }
 
    set_state_idle (MBXout, index, subindex, 0);
@@ -1054,40 +1343,34 @@ static void SDO_downloadsegment (void)
       init_coesdo(coeres, COE_SDORESPONSE, command, 0, 0);
 
       void *mbxdata = &(coesdo->index);  /* data pointer */
-      copy2mbx (mbxdata, ESCvar.data, size);
-
-      if (coesdo->command & COE_COMMAND_LASTSEGMENTBIT)
+      if (ESCvar.flags == COMPLETE_ACCESS_FLAG)
       {
-         if(ESCvar.flags == COMPLETE_ACCESS_FLAG)
+         /* The segments are streamed straight into the subindexes, there is
+          * no room to stage a whole object. A download aborted here leaves
+          * the segments already received written, so it is not atomic; the
+          * size is at least checked before the last segment is written.
+          */
+         if ((coesdo->command & COE_COMMAND_LASTSEGMENTBIT) ?
+             (ESCvar.frags != ESCvar.fragsleft + size) :
+             (ESCvar.frags < ESCvar.fragsleft + size))
          {
-            int32_t nidx;
-            int16_t nsub;
-
-            if(ESCvar.frags > ESCvar.fragsleft + size)
-            {
-               set_state_idle (0, ESCvar.index, ESCvar.subindex, ABORT_TYPEMISMATCH);
-               return;
-            }
-
-            nidx = SDO_findobject(ESCvar.index);
-            nsub = SDO_findsubindex (nidx, ESCvar.subindex);
-
-            if ((nidx < 0) || (nsub < 0))
-            {
-               set_state_idle (0, ESCvar.index, ESCvar.subindex, ABORT_NOOBJECT);
-               return;
-            }
-
-            /* copy download data to subindexes */
-            const _objd *objd = SDOobjects[nidx].objdesc;
-            complete_access_subindex_loop(objd,
-                  nidx,
-                  nsub,
-                  (uint8_t *)ESCvar.mbxdata,
-                  DOWNLOAD,
-                  ESCvar.frags);
-
+            ESCvar.segmented = 0;
+            ESCvar.frags = 0;
+            ESCvar.fragsleft = 0;
+            set_state_idle (MBXout, ESCvar.index, ESCvar.subindex,
+                            ABORT_TYPEMISMATCH);
+            return;
          }
+         /* copy download data to subindexes */
+         complete_access_stream (mbxdata, ESCvar.fragsleft, size, DOWNLOAD);
+      }
+      else
+      {
+         copy2mbx (mbxdata, ESCvar.data, size);
+      }
+
+      if (coesdo->command & COE_COMMAND_LASTSEGMENTBIT)
+      {
          /* last segment */
          ESCvar.segmented = 0;
          ESCvar.frags = 0;
@@ -1109,7 +1392,7 @@ static void SDO_downloadsegment (void)
          ESCvar.fragsleft += size;
       }
 
-      MBXcontrol[MBXout].state = MBXstate_outreq;
+      ESC_mbxpost (MBXout);
    }
 
    set_state_idle (0, 0, 0, 0);
@@ -1138,7 +1421,7 @@ static void SDO_infoerror (uint32_t abortcode)
       coeres->infoheader.fragmentsleft = 0;
       coeres->index = (uint16_t)htoel (abortcode);
       coeres->datatype = (uint16_t)(htoel (abortcode) >> 16);
-      MBXcontrol[MBXout].state = MBXstate_outreq;
+      ESC_mbxpost (MBXout);
       MBXcontrol[0].state = MBXstate_idle;
       ESCvar.xoe = 0;
    }
@@ -1153,15 +1436,12 @@ static void SDO_getodlist (void)
 {
    uint32_t frags;
    uint8_t MBXout = 0;
-   uint16_t entries = 0;
+   uint16_t entries;
    uint16_t i, n;
    uint16_t *p;
    _COEobjdesc *coel, *coer;
 
-   while (SDOobjects[entries].index != 0xffff)
-   {
-      entries++;
-   }
+   entries = SDO_objectcount ();
    ESCvar.entries = entries;
    frags = ((uint32_t)(entries << 1) + ODLISTSIZE - 1U);
    frags /= ODLISTSIZE;
@@ -1236,7 +1516,7 @@ static void SDO_getodlist (void)
 
          coel->mbxheader.length = htoes (0x08 + (n << 1));
       }
-      MBXcontrol[MBXout].state = MBXstate_outreq;
+      ESC_mbxpost (MBXout);
    }
 }
 /** Function for continuing sending left overs from previous requested
@@ -1281,7 +1561,7 @@ static void SDO_getodlistcont (void)
          p++;
       }
       coel->mbxheader.length = htoes (0x06 + ((n - s) << 1));
-      MBXcontrol[MBXout].state = MBXstate_outreq;
+      ESC_mbxpost (MBXout);
    }
 }
 
@@ -1346,7 +1626,7 @@ static void SDO_getod (void)
          }
          *d = *s;
          coel->mbxheader.length = htoes (0x0C + n);
-         MBXcontrol[MBXout].state = MBXstate_outreq;
+         ESC_mbxpost (MBXout);
          MBXcontrol[0].state = MBXstate_idle;
          ESCvar.xoe = 0;
       }
@@ -1412,7 +1692,7 @@ static void SDO_geted (void)
             }
             *d = *s;
             coel->mbxheader.length = htoes (0x10 + n);
-            MBXcontrol[MBXout].state = MBXstate_outreq;
+            ESC_mbxpost (MBXout);
             MBXcontrol[0].state = MBXstate_idle;
             ESCvar.xoe = 0;
          }
@@ -1467,6 +1747,13 @@ void ESC_coeprocess (void)
       coesdo = (_COEsdo *) &MBX[0];
       coeobjdesc = (_COEobjdesc *) &MBX[0];
       service = etohs (coesdo->coeheader.numberservice) >> 12;
+      if ((ESCvar.segnext != 0) && ((service != COE_SDOREQUEST) ||
+            ((coesdo->command & 0xef) != COE_COMMAND_UPLOADSEGREQ)))
+      {
+         /* segmented upload abandoned, drop the prepared segment */
+         ESC_releasebuffer (ESCvar.segnext);
+         ESCvar.segnext = 0;
+      }
       if (service == COE_SDOREQUEST)
       {
          if ((SDO_COMMAND(coesdo->command) == COE_COMMAND_UPLOADREQUEST)
@@ -1623,6 +1910,183 @@ static void COE_bitsliceSet (uint64_t * bitmap, unsigned int offset, unsigned in
    }
 }
 
+/**
+ * Pack a run of 1-bit values into a bitmap
+ *
+ * Bit 0 of each of the count bytes at data is set in the bitmap, 64
+ * bits per bitmap access. Bytes are gathered 16 at a time with SSE2
+ * and 8 at a time with a multiply otherwise. Little endian only.
+ *
+ * @param[in] bitmap = bitmap to contain the values
+ * @param[in] offset = start offset
+ * @param[in] data   = one byte per value
+ * @param[in] count  = number of values
+ */
+static void COE_bitrunPack (uint64_t * bitmap, unsigned int offset,
+                            const uint8_t * data, unsigned int count)
+{
+   while (count > 0)
+   {
+      const unsigned int length = (count > 64) ? 64 : count;
+      uint64_t value = 0;
+      unsigned int n = 0;
+
+#if defined(__SSE2__)
+      for (; n + 16 <= length; n += 16)
+      {
+         __m128i v = _mm_loadu_si128 ((const __m128i *)(data + n));
+         value |= (uint64_t)(uint16_t)_mm_movemask_epi8 (_mm_slli_epi16 (v, 7))
+            << n;
+      }
+#endif
+      for (; n + 8 <= length; n += 8)
+      {
+         uint64_t v;
+
+         memcpy (&v, data + n, sizeof (v));
+         v = ((v & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56;
+         value |= v << n;
+      }
+      for (; n < length; n++)
+      {
+         value |= (uint64_t)(data[n] & 1U) << n;
+      }
+
+      COE_bitsliceSet (bitmap, offset, length, value);
+      offset += length;
+      data += length;
+      count -= length;
+   }
+}
+
+/**
+ * Unpack a run of 1-bit values from a bitmap
+ *
+ * Each bit is stored as 0 or 1 in one of the count bytes at data, 64
+ * bits per bitmap access and 8 bytes per store. Little endian only.
+ *
+ * @param[in] bitmap = bitmap containing the values
+ * @param[in] offset = start offset
+ * @param[in] data   = one byte per value
+ * @param[in] count  = number of values
+ */
+static void COE_bitrunUnpack (uint64_t * bitmap, unsigned int offset,
+                              uint8_t * data, unsigned int count)
+{
+   while (count > 0)
+   {
+      const unsigned int length = (count > 64) ? 64 : count;
+      uint64_t value = COE_bitsliceGet (bitmap, offset, length);
+      unsigned int n;
+
+      for (n = 0; n + 8 <= length; n += 8)
+      {
+         /* Bit k of the byte to bit 0 of byte k */
+         uint64_t v = ((value >> n) & 0xFF) * 0x0101010101010101ULL;
+
+         v &= 0x8040201008040201ULL;
+         v = ((v + 0x7F7F7F7F7F7F7F7FULL) >> 7) & 0x0101010101010101ULL;
+         memcpy (data + n, &v, sizeof (v));
+      }
+      for (; n < length; n++)
+      {
+         data[n] = (value >> n) & 1U;
+      }
+
+      offset += length;
+      data += length;
+      count -= length;
+   }
+}
+
+/**
+ * Copy process data
+ *
+ * Copies of a single scalar object are done with a fixed size so
+ * that they compile to plain loads and stores.
+ *
+ * @param[in] dest   = pointer to destination
+ * @param[in] source = pointer to source
+ * @param[in] length = number of bytes to copy
+ */
+static void COE_copy (void * dest, const void * source, uint16_t length)
+{
+   switch(length)
+   {
+   case 1:
+      memcpy (dest, source, 1);
+      break;
+   case 2:
+      memcpy (dest, source, 2);
+      break;
+   case 4:
+      memcpy (dest, source, 4);
+      break;
+   case 8:
+      memcpy (dest, source, 8);
+      break;
+   default:
+      memcpy (dest, source, length);
+      break;
+   }
+}
+
+/**
+ * Get data of known size
+ *
+ * This function atomically gets the value stored at data, using
+ * the storage size resolved by the copy plan.
+ *
+ * @param[in] data   = pointer to object data
+ * @param[in] size   = size of storage in bytes
+ * @return object value
+ */
+static uint64_t COE_getData (const void * data, uint16_t size)
+{
+   switch(size)
+   {
+   case 1:
+      return *(const uint8_t *)data;
+   case 2:
+      return *(const uint16_t *)data;
+   case 4:
+      return *(const uint32_t *)data;
+   default:
+      /* FIXME: must be atomic */
+      return *(const uint64_t *)data;
+   }
+}
+
+/**
+ * Set data of known size
+ *
+ * This function atomically sets the value stored at data, using
+ * the storage size resolved by the copy plan.
+ *
+ * @param[in] data   = pointer to object data
+ * @param[in] size   = size of storage in bytes
+ * @param[in] value  = new value
+ */
+static void COE_setData (void * data, uint16_t size, uint64_t value)
+{
+   switch(size)
+   {
+   case 1:
+      *(uint8_t *)data = value & UINT8_MAX;
+      break;
+   case 2:
+      *(uint16_t *)data = value & UINT16_MAX;
+      break;
+   case 4:
+      *(uint32_t *)data = value & UINT32_MAX;
+      break;
+   default:
+      /* FIXME: must be atomic */
+      *(uint64_t *)data = value;
+      break;
+   }
+}
+
 /**
  * Get object value
  *
@@ -1736,6 +2200,11 @@ static void COE_setValue (const _objd * obj, uint64_t value)
 
 /**
  * Init default values for SDO objects
+ *
+ * If the application supplies an image of the default values of its object
+ * storage, the storage is initialized with a single copy of the image and
+ * only objects with data outside of the storage are set one by one from
+ * their object descriptor.
  */
 void COE_initDefaultValues (void)
 {
@@ -1743,6 +2212,7 @@ void COE_initDefaultValues (void)
    const _objd *objd;
    int n;
    uint8_t maxsub;
+   uintptr_t store = (uintptr_t)ESCvar.default_store;
 
    /* Let application decide if initialization will be skipped */
    if (ESCvar.skip_default_initialization)
@@ -1750,6 +2220,13 @@ void COE_initDefaultValues (void)
       return;
    }
 
+   /* Set default values of the object storage from the image */
+   if (ESCvar.default_size > 0)
+   {
+      memcpy (ESCvar.default_store, ESCvar.default_image,
+              ESCvar.default_size);
+   }
+
    /* Set default values from object descriptor */
    for (n = 0; SDOobjects[n].index != 0xffff; n++)
    {
@@ -1759,7 +2236,8 @@ void COE_initDefaultValues (void)
       i = 0;
       do
       {
-         if (objd[i].data != NULL)
+         if ((objd[i].data != NULL) &&
+             (((uintptr_t)objd[i].data - store) >= ESCvar.default_size))
          {
             COE_setValue (&objd[i], objd[i].value);
             DPRINT ("%04"PRIx32":%02"PRIx32" = %"PRIx32"\n",
@@ -1796,30 +2274,64 @@ void COE_pdoPack (uint8_t * buffer, int nmappings, _SMmap * mappings)
 
    for (ix = 0; ix < nmappings; ix++)
    {
-      const _objd * obj = mappings[ix].obj;
-      uint32_t offset = mappings[ix].offset;
+      const _SMmap * mapping = &mappings[ix];
+      const _objd * obj = mapping->obj;
+      uint32_t offset = mapping->offset;
 
-      if (obj != NULL)
+      switch(mapping->op)
       {
-         if (obj->bitlength > 64)
-         {
-            memcpy (
-               &buffer[BITSPOS2BYTESOFFSET (offset)],
-               obj->data,
-               BITS2BYTES (obj->bitlength)
-            );
-         }
-         else
+      case SMMAP_OP_COPY:
+         COE_copy (
+            &buffer[BITSPOS2BYTESOFFSET (offset)],
+            mapping->data,
+            mapping->length
+         );
+         ix += mapping->span - 1;
+         break;
+
+      case SMMAP_OP_BITS:
+         COE_bitsliceSet (
+            (uint64_t *)buffer,
+            offset,
+            obj->bitlength,
+            COE_getData (mapping->data, mapping->length)
+         );
+         break;
+
+      case SMMAP_OP_BITRUN:
+         COE_bitrunPack (
+            (uint64_t *)buffer,
+            offset,
+            mapping->data,
+            mapping->length
+         );
+         ix += mapping->span - 1;
+         break;
+
+      default:
+         if (obj != NULL)
          {
-            /* Atomically get object value */
-            uint64_t value = COE_getValue (obj);
-            COE_bitsliceSet (
-               (uint64_t *)buffer,
-               offset,
-               obj->bitlength,
-               value
-            );
+            if (obj->bitlength > 64)
+            {
+               memcpy (
+                  &buffer[BITSPOS2BYTESOFFSET (offset)],
+                  obj->data,
+                  BITS2BYTES (obj->bitlength)
+               );
+            }
+            else
+            {
+               /* Atomically get object value */
+               uint64_t value = COE_getValue (obj);
+               COE_bitsliceSet (
+                  (uint64_t *)buffer,
+                  offset,
+                  obj->bitlength,
+                  value
+               );
+            }
          }
+         break;
       }
    }
 }
@@ -1843,33 +2355,93 @@ void COE_pdoUnpack (uint8_t * buffer, int nmappings, _SMmap * mappings)
 
    for (ix = 0; ix < nmappings; ix++)
    {
-      const _objd * obj = mappings[ix].obj;
-      uint32_t offset = mappings[ix].offset;
+      const _SMmap * mapping = &mappings[ix];
+      const _objd * obj = mapping->obj;
+      uint32_t offset = mapping->offset;
 
-      if (obj != NULL)
+      switch(mapping->op)
       {
-         if (obj->bitlength > 64)
-         {
-            memcpy (
-               obj->data,
-               &buffer[BITSPOS2BYTESOFFSET (offset)],
-               BITS2BYTES (obj->bitlength)
-            );
-         }
-         else
+      case SMMAP_OP_COPY:
+         COE_copy (
+            mapping->data,
+            &buffer[BITSPOS2BYTESOFFSET (offset)],
+            mapping->length
+         );
+         ix += mapping->span - 1;
+         break;
+
+      case SMMAP_OP_BITS:
+         COE_setData (
+            mapping->data,
+            mapping->length,
+            COE_bitsliceGet ((uint64_t *)buffer, offset, obj->bitlength)
+         );
+         break;
+
+      case SMMAP_OP_BITRUN:
+         COE_bitrunUnpack (
+            (uint64_t *)buffer,
+            offset,
+            mapping->data,
+            mapping->length
+         );
+         ix += mapping->span - 1;
+         break;
+
+      default:
+         if (obj != NULL)
          {
-            /* Atomically set object value */
-            uint64_t value = COE_bitsliceGet (
-               (uint64_t *)buffer,
-               offset,
-               obj->bitlength
-            );
-            COE_setValue (obj, value);
+            if (obj->bitlength > 64)
+            {
+               memcpy (
+                  obj->data,
+                  &buffer[BITSPOS2BYTESOFFSET (offset)],
+                  BITS2BYTES (obj->bitlength)
+               );
+            }
+            else
+            {
+               /* Atomically set object value */
+               uint64_t value = COE_bitsliceGet (
+                  (uint64_t *)buffer,
+                  offset,
+                  obj->bitlength
+               );
+               COE_setValue (obj, value);
+            }
          }
+         break;
       }
    }
 }
 
+/**
+ * Get process data image
+ *
+ * This function checks if the process data is the exact memory
+ * layout of the mapped objects, i.e. the copy plan is a single copy
+ * covering all mappings and the whole process data.
+ *
+ * @param[in] nmappings = number of mappings in sync manager
+ * @param[in] mappings  = list of mapped objects in sync manager
+ * @param[in] size      = size of process data in bytes
+ * @return pointer to the memory of the mapped objects, or NULL if
+ * process data must be packed or unpacked
+ */
+void * COE_pdoImage (int nmappings, _SMmap * mappings, uint16_t size)
+{
+   if ((nmappings > 0) &&
+       (mappings[0].op == SMMAP_OP_COPY) &&
+       (mappings[0].offset == 0) &&
+       (mappings[0].span == nmappings) &&
+       (mappings[0].length == size))
+   {
+      return mappings[0].data;
+   }
+
+   return NULL;
+}
+
 /**
  * Fetch max subindex
  *
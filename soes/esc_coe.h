@@ -37,11 +37,22 @@ typedef struct
 } _objectlist;
 
 
+/* Process data copy plan operations, see sizeOfPDO */
+#define SMMAP_OP_NONE           0
+#define SMMAP_OP_COPY           1
+#define SMMAP_OP_BITS           2
+#define SMMAP_OP_BITRUN         3
+
 typedef struct
 {
    const _objd * obj;
    const _objectlist * objectlistitem;
    uint32_t offset;
+   /* Copy plan, valid in the first mapping of each operation */
+   void * data;
+   uint16_t length;
+   uint16_t span;
+   uint8_t op;
 } _SMmap;
 
 #define OBJH_READ               0
@@ -115,10 +126,12 @@ void ESC_coeprocess (void);
 int16_t SDO_findsubindex (int32_t nidx, uint8_t subindex);
 int32_t SDO_findobject (uint16_t index);
 uint16_t sizeOfPDO (uint16_t index, int * nmappings, _SMmap * sm, int max_mappings);
+void COE_pdoPlan (_SMmap * sm, int nmappings);
 void COE_initDefaultValues (void);
 
 void COE_pdoPack (uint8_t * buffer, int nmappings, _SMmap * sm);
 void COE_pdoUnpack (uint8_t * buffer, int nmappings, _SMmap * sm);
+void * COE_pdoImage (int nmappings, _SMmap * sm, uint16_t size);
 uint8_t COE_maxSub (uint16_t index);
 
 extern uint32_t ESC_download_post_objecthandler (uint16_t index, uint8_t subindex, uint16_t flags);
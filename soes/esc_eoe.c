@@ -492,7 +492,7 @@ static void EOE_no_data_response (uint16_t frameinfo1, uint16_t result)
       eoembx->mbxheader.mbxtype = MBXEOE;
       eoembx->eoeheader.frameinfo1 = htoes(frameinfo1);
       eoembx->eoeheader.result = htoes(result);
-      MBXcontrol[mbxhandle].state = MBXstate_outreq;
+      ESC_mbxpost (mbxhandle);
    }
 }
 
@@ -539,7 +539,7 @@ static void EOE_get_ip (void)
    {
       eoembx = (_EOE *) &MBX[mbxhandle * ESC_MBXSIZE];
       eoembx->mbxheader.mbxtype = MBXEOE;
-      MBXcontrol[mbxhandle].state = MBXstate_outreq;
+      ESC_mbxpost (mbxhandle);
       frameinfo1 = EOE_HDR_FRAME_PORT_SET(port);
       frameinfo1 |= EOE_HDR_FRAME_TYPE_SET(EOE_GET_IP_PARAM_RESP);
       frameinfo1 |= EOE_HDR_LAST_FRAGMENT;
@@ -855,11 +855,10 @@ static void EOE_send_fragment ()
    if (mbxhandle)
    {
       len_to_send = (EOEvar.txframesize - EOEvar.txframeoffset);
-      if((len_to_send + ESC_EOEHSIZE + ESC_MBXHSIZE) > ESC_MBXSIZE)
+      if(len_to_send > ESC_EOE_DATA_SIZE)
       {
          /* Adjust to len in whole 32 octet blocks to fit specification*/
-         len_to_send =
-               (((ESC_MBXSIZE - ESC_EOEHSIZE - ESC_MBXHSIZE) >> 5) << 5);
+         len_to_send = ((ESC_EOE_DATA_SIZE >> 5) << 5);
       }
 
       /* TODO: port handling? */
@@ -903,7 +902,7 @@ static void EOE_send_fragment ()
       memcpy(eoembx->data,
             &EOEvar.txebuf.payload[EOEvar.txframeoffset],
             len_to_send);
-      MBXcontrol[mbxhandle].state = MBXstate_outreq;
+      ESC_mbxpost (mbxhandle);
 
       /* Did we complete the frame? */
       if(len_to_send == (EOEvar.txframesize - EOEvar.txframeoffset))
@@ -21,9 +21,6 @@
  * FOE read / write and FOE service functions
  */
 
-//define if FOE_read should be supported
-//#define FOE_READ_SUPPORTED
-
 /** Variable holding current filename read at FOE Open.
  */
 static char foe_file_name[FOE_FN_MAX + 1];
@@ -36,11 +33,108 @@ static foe_cfg_t * foe_cfg;
 /** Pointer to current file configuration item used by FoE.
  */
 static foe_file_cfg_t * foe_file;
+/** File buffers and their size used by the current file.
+ */
+static uint8_t * foe_fbuffer[2];
+static uint32_t foe_buffer_size;
 /** Main FoE status data array. Structure gets filled with current status
  * variables during FoE usage.
  */
 static _FOEvar FOEvar;
 
+#if USE_FOE_CRC32
+/** CRC32 lookup table, reflected polynomial 0xEDB88320.
+ */
+static const uint32_t foe_crc32_table[256] =
+{
+   0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
+   0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
+   0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
+   0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+   0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
+   0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
+   0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
+   0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+   0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
+   0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
+   0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
+   0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+   0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
+   0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
+   0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
+   0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+   0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
+   0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
+   0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
+   0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+   0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
+   0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
+   0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
+   0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+   0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
+   0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
+   0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
+   0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+   0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
+   0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
+   0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
+   0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+   0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
+   0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
+   0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
+   0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+   0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
+   0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
+   0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
+   0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+   0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
+   0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
+   0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+};
+
+/** Continue the CRC32 of a file over the data received. Uses the application
+ * CRC32 function if configured.
+ *
+ * @param[in] crc       = CRC32 of previous data, 0 to start
+ * @param[in] data      = Pointer to data
+ * @param[in] length    = Length of data
+ * @return CRC32 including data
+ */
+static uint32_t FOE_crc32 (uint32_t crc, const uint8_t * data, size_t length)
+{
+   if (foe_cfg->crc32_function != NULL)
+   {
+      return foe_cfg->crc32_function (crc, data, length);
+   }
+
+   crc = ~crc;
+   while (length--)
+   {
+      crc = foe_crc32_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+   }
+
+   return ~crc;
+}
+#endif
+
+/** Calculate the FNV-1a hash of a file name.
+ *
+ * @param[in] name      = Null terminated file name
+ * @return hash of name
+ */
+static uint32_t FOE_hash (const char * name)
+{
+   uint32_t hash = 2166136261U;
+
+   while (*name != '\0')
+   {
+      hash ^= (uint8_t)*name++;
+      hash *= 16777619U;
+   }
+
+   return hash;
+}
+
 /** Validate a write or read request by checking filename and password.
  *
  * @param[in] name      = Filename
@@ -48,11 +142,15 @@ static _FOEvar FOEvar;
  * @param[in] pass      = Numeric variable of password
  * @param[in] op        = Request op-code
  * @return 0= if we succeed, FOE_ERR_NOTFOUND something wrong with filename or
- * password
+ * password, FOE_ERR_ACCESS if the file has no hook or buffer for the request
  */
 static uint32_t FOE_fopen (char *name, uint8_t num_chars, uint32_t pass, uint8_t op)
 {
    uint32_t i;
+   uint32_t hash;
+   uint8_t * fbuffer;
+   uint8_t * fbuffer2;
+   uint32_t buffer_size;
 
    /* Unpack the file name into characters we can look at. */
    if (num_chars > FOE_FN_MAX)
@@ -65,11 +163,13 @@ static uint32_t FOE_fopen (char *name, uint8_t num_chars, uint32_t pass, uint8_t
       foe_file_name[i] = name[i];
    }
    foe_file_name[i] = '\0';
+   hash = FOE_hash (foe_file_name);
 
    /* Figure out what file they're talking about. */
    for (i = 0; i < foe_cfg->n_files; i++)
    {
-      if (0 == strncmp (foe_file_name, foe_cfg->files[i].name, num_chars))
+      if ((foe_cfg->files[i].name_hash == hash) &&
+          (0 == strcmp (foe_file_name, foe_cfg->files[i].name)))
       {
          if (pass != foe_cfg->files[i].filepass)
          {
@@ -84,59 +184,146 @@ static uint32_t FOE_fopen (char *name, uint8_t num_chars, uint32_t pass, uint8_t
          }
 
          foe_file = &foe_cfg->files[i];
-         foe_file->address_offset = 0;
-         foe_file->total_size = 0;
          switch (op)
          {
             case FOE_OP_RRQ:
             {
-               FOEvar.fposition = 0;
-               FOEvar.fend = foe_cfg->files[i].max_data;
-               return 0;
+               if (foe_file->read_function == NULL)
+               {
+                  return FOE_ERR_ACCESS;
+               }
+               break;
             }
             case FOE_OP_WRQ:
             {
-               FOEvar.fposition = 0;
-               FOEvar.fend = foe_cfg->files[i].max_data;
-               return 0;
+               if (foe_file->fbuffer != NULL)
+               {
+                  fbuffer = foe_file->fbuffer;
+                  fbuffer2 = foe_file->fbuffer2;
+                  buffer_size = foe_file->buffer_size;
+               }
+               else
+               {
+                  fbuffer = foe_cfg->fbuffer;
+                  fbuffer2 = foe_cfg->fbuffer2;
+                  buffer_size = foe_cfg->buffer_size;
+               }
+               /* Data is always staged in a buffer and written by either
+                * hook, the async one only when there is a second buffer.
+                */
+               if ((fbuffer == NULL) || (buffer_size == 0) ||
+                   ((foe_file->write_function == NULL) &&
+                    ((fbuffer2 == NULL) ||
+                     (foe_file->write_async_function == NULL))))
+               {
+                  return FOE_ERR_ACCESS;
+               }
+               foe_fbuffer[0] = fbuffer;
+               foe_fbuffer[1] = fbuffer2;
+               foe_buffer_size = buffer_size;
+               if (foe_fbuffer[1] == NULL)
+               {
+                  FOEvar.fbufindex = 0;
+               }
+               break;
+            }
+            default:
+            {
+               return FOE_ERR_NOTFOUND;
             }
          }
+         foe_file->address_offset = 0;
+         foe_file->total_size = 0;
+         foe_file->crc32 = 0;
+         FOEvar.fposition = 0;
+         FOEvar.fend = foe_cfg->files[i].max_data;
+         return 0;
       }
    }
 
    return FOE_ERR_NOTFOUND;
 }
 
-#ifdef FOE_READ_SUPPORTED
 /** Function writing local data to mailbox buffer to be sent as next FoE frame.
- * It will try to fill the Mailbox buffer available if there is enough data
- * left to read.
+ * The application read hook fills the mailbox buffer directly, as much as
+ * available if there is enough data left to read.
  *
  * @param[in] data      = pointer to buffer
  * @param[in] maxlength = max length of data possible to read, controlled by
  * Mailbox - FoE and Mailbox frame headers.
 
- * @return Number of copied bytes.
+ * @return Number of copied bytes, or an error number greater than maxlength.
  */
 static uint32_t FOE_fread (uint8_t * data, uint32_t maxlength)
 {
-   uint32_t ncopied = 0;
+   uint32_t ncopied;
 
-   while (maxlength && (FOEvar.fend - FOEvar.fposition))
+   FOEvar.fprevposition = FOEvar.fposition;
+   maxlength = MIN (maxlength, FOEvar.fend - FOEvar.fposition);
+   foe_file->address_offset = FOEvar.fposition;
+   ncopied = foe_file->read_function (foe_file, data, maxlength);
+   if (ncopied > maxlength)
    {
-      maxlength--;
-      *(data++) = foe_cfg->fbuffer[FOEvar.fposition++];
-      ncopied++;
+      DPRINT("Failed FOE_fread 0x%"PRIX32"\n", ncopied);
+      return (ncopied >= FOE_ERR_NOTDEFINED) ? ncopied : FOE_ERR_PROGERROR;
    }
+   FOEvar.fposition += ncopied;
+   foe_file->total_size += ncopied;
 
    return ncopied;
 }
-#endif
+
+/** Return value of FOE_fclose while the last file buffer is being written. */
+#define FOE_PENDING     1
+
+/** Function handing the filled part of the current file buffer to the
+ * application write hook. With a second file buffer and an asynchronous write
+ * hook the buffers are swapped, so the next one can be filled while the
+ * previous one is written. A failed write is stored in FOEvar.fwriteerror.
+ *
+ * @return 0= buffer handed over, 1= both buffers busy, try again later
+ */
+static uint8_t FOE_fflush (void)
+{
+   uint8_t * buffer;
+   uint32_t failed;
+
+   buffer = foe_fbuffer[FOEvar.fbufindex];
+   if ((foe_fbuffer[1] != NULL) && (foe_file->write_async_function != NULL))
+   {
+      if (CC_ATOMIC_GET (FOEvar.fwritebusy))
+      {
+         return 1;
+      }
+      CC_ATOMIC_SET (FOEvar.fwritegeneration, FOEvar.fgeneration);
+      CC_ATOMIC_SET (FOEvar.fwritebusy, 1);
+      failed = foe_file->write_async_function (foe_file, buffer, FOEvar.fbufposition);
+      if (failed)
+      {
+         CC_ATOMIC_SET (FOEvar.fwritebusy, 0);
+      }
+      FOEvar.fbufindex ^= 1;
+   }
+   else
+   {
+      failed = foe_file->write_function (foe_file, buffer, FOEvar.fbufposition);
+   }
+   if (failed)
+   {
+      DPRINT("Failed FOE_fflush 0x%"PRIX32"\n", failed);
+      FOEvar.fwriteerror = failed;
+   }
+   foe_file->address_offset += FOEvar.fbufposition;
+   FOEvar.fbufposition = 0;
+
+   return 0;
+}
 
 /** Function reading mailbox buffer to local buffer to be handled by
  * application write hook. Ex. flash routine used by software update.
  * It will consume the buffer and call the write hook every time the configured
- * flush buffer limit is reached.
+ * flush buffer limit is reached. It stops early if both file buffers are
+ * busy or a write failed.
  *
  *
  * @param[in] data   = Pointer to buffer
@@ -147,29 +334,34 @@ static uint32_t FOE_fread (uint8_t * data, uint32_t maxlength)
 static uint32_t FOE_fwrite (uint8_t *data, uint32_t length)
 {
     uint32_t ncopied = 0;
-    uint32_t failed = 0;
+    uint32_t n;
 
     DPRINT("FOE_fwrite\n");
     FOEvar.fprevposition = FOEvar.fposition;
-    while (length && (FOEvar.fend - FOEvar.fposition) && !failed)
+    while (length && (FOEvar.fend - FOEvar.fposition) && !FOEvar.fwriteerror)
     {
-       length--;
-       foe_cfg->fbuffer[FOEvar.fbufposition++] = *(data++);
-       if(FOEvar.fbufposition >= foe_cfg->buffer_size)
+       if ((FOEvar.fbufposition >= foe_buffer_size) && FOE_fflush ())
        {
-          failed = foe_file->write_function (foe_file, foe_cfg->fbuffer, FOEvar.fbufposition);
-          FOEvar.fbufposition = 0;
-          foe_file->address_offset += foe_cfg->buffer_size;
-       }
-       FOEvar.fposition++;
-       if(failed)
-       {
-          DPRINT("Failed FOE_fwrite ncopied=%"PRIu32"\n", ncopied);
-       }
-       else
-       {
-          ncopied++;
+          break;
        }
+       n = MIN (length, foe_buffer_size - FOEvar.fbufposition);
+       n = MIN (n, FOEvar.fend - FOEvar.fposition);
+       memcpy (&foe_fbuffer[FOEvar.fbufindex][FOEvar.fbufposition], data, n);
+#if USE_FOE_CRC32
+       foe_file->crc32 = FOE_crc32 (foe_file->crc32, data, n);
+#endif
+       FOEvar.fbufposition += n;
+       FOEvar.fposition += n;
+       data += n;
+       length -= n;
+       ncopied += n;
+    }
+    /* Hand over a full buffer right away, so writing it overlaps with the
+     * next mailbox transfer
+     */
+    if ((FOEvar.fbufposition >= foe_buffer_size) && !FOEvar.fwriteerror)
+    {
+       (void)FOE_fflush ();
     }
 
     foe_file->total_size += ncopied;
@@ -180,21 +372,49 @@ static uint32_t FOE_fwrite (uint8_t *data, uint32_t length)
 
 
 /** Function handling the final FOE_fwrite when we close up regardless
- * if we have filled the buffers or not.
+ * if we have filled the buffers or not. With asynchronous writes the file is
+ * closed once the last buffer is handed over and written. The application
+ * close hook is called last, with the final size and CRC32 of the file.
  *
- * @return Number of copied bytes on success, 0= if failed.
+ * @return 0= on success, FOE_PENDING= try again later, else FOE_ERR_ code.
  */
 static uint32_t FOE_fclose (void)
 {
-   uint32_t failed = 0;
+   uint32_t failed;
 
    DPRINT("FOE_fclose\n");
-   
-   failed = foe_file->write_function (foe_file, foe_cfg->fbuffer, FOEvar.fbufposition);
-   foe_file->address_offset += FOEvar.fbufposition;
-   FOEvar.fbufposition = 0;
 
-   return failed;
+   if ((FOEvar.fbufposition >= foe_buffer_size) && FOE_fflush ())
+   {
+      return FOE_PENDING;
+   }
+   if (!FOEvar.fclosed)
+   {
+      if (FOE_fflush ())
+      {
+         return FOE_PENDING;
+      }
+      FOEvar.fclosed = 1;
+   }
+   if (CC_ATOMIC_GET (FOEvar.fwritebusy))
+   {
+      return FOE_PENDING;
+   }
+   if (FOEvar.fwriteerror)
+   {
+      return FOE_ERR_PROGERROR;
+   }
+   if (foe_file->close_function != NULL)
+   {
+      failed = foe_file->close_function (foe_file);
+      if (failed)
+      {
+         DPRINT("Failed FOE_fclose 0x%"PRIX32"\n", failed);
+         return (failed >= FOE_ERR_NOTDEFINED) ? failed : FOE_ERR_PROGERROR;
+      }
+   }
+
+   return 0;
 }
 
 /** Initialize by clearing all current status variables.
@@ -208,6 +428,13 @@ void FOE_init ()
    FOEvar.fposition = 0;
    FOEvar.fprevposition = 0;
    FOEvar.fbufposition = 0;
+   FOEvar.fpacketpos = 0;
+   FOEvar.fclosed = 0;
+   FOEvar.fwriteerror = 0;
+   /* fbufindex and fwritebusy are kept, a buffer may still be written. Its
+    * completion belongs to the previous transfer
+    */
+   CC_ATOMIC_ADD (FOEvar.fgeneration, 1);
 }
 
 /** Function for sending an FOE abort frame.
@@ -230,7 +457,7 @@ static void FOE_abort (uint32_t code)
          foembx->mbxheader.mbxtype = MBXFOE;
          foembx->foeheader.opcode = FOE_OP_ERR;
          foembx->foeheader.errorcode = htoel (code);
-         MBXcontrol[mbxhandle].state = MBXstate_outreq;
+         ESC_mbxpost (mbxhandle);
       }
       /* Nothing we can do if we can't get an outbound mailbox. */
    }
@@ -238,7 +465,6 @@ static void FOE_abort (uint32_t code)
    FOE_init ();
 }
 
-#ifdef FOE_READ_SUPPORTED
 /** Sends an FoE data frame, returning the number of data bytes
  * written or an error number.
  * Error numbers will be greater than FOE_DATA_SIZE.
@@ -260,13 +486,18 @@ static uint32_t FOE_send_data_packet ()
    {
       foembx = (_FOE *) &MBX[mbxhandle * ESC_MBXSIZE];
       data_len = FOE_fread (foembx->data, ESC_FOE_DATA_SIZE);
+      if (data_len > ESC_FOE_DATA_SIZE)
+      {
+         ESC_releasebuffer (mbxhandle);
+         return data_len;
+      }
       foembx->foeheader.opcode = FOE_OP_DATA;
       foembx->foeheader.packetnumber = htoel (FOEvar.foepacket);
       FOEvar.foepacket++;
       foembx->mbxheader.length = htoes (data_len + ESC_FOEHSIZE);
       foembx->mbxheader.mbxtype = MBXFOE;
       /* Mark the outbound mailbox as filled. */
-      MBXcontrol[mbxhandle].state = MBXstate_outreq;
+      ESC_mbxpost (mbxhandle);
       return data_len;
    }
    else
@@ -274,7 +505,6 @@ static uint32_t FOE_send_data_packet ()
       return FOE_ERR_PROGERROR;
    }
 }
-#endif
 
 /** Sends an FoE ack data frame.
 
@@ -295,7 +525,7 @@ static uint32_t FOE_send_ack ()
       foembx->foeheader.opcode = FOE_OP_ACK;
       foembx->foeheader.packetnumber = htoel (FOEvar.foepacket);
       FOEvar.foepacket++;
-      MBXcontrol[mbxhandle].state = MBXstate_outreq;
+      ESC_mbxpost (mbxhandle);
       return 0;
    }
    else
@@ -305,9 +535,45 @@ static uint32_t FOE_send_ack ()
    }
 }
 
+/** Sends an FoE busy frame with the progress of the file received so far,
+ * scaled to fit the 16 bit done and entire fields.
+
+ * @return 0= or error number.
+ */
+static uint32_t FOE_send_busy ()
+{
+   _FOE *foembx;
+   uint8_t mbxhandle;
+   uint32_t done = FOEvar.fposition;
+   uint32_t entire = FOEvar.fend;
+
+   mbxhandle = ESC_claimbuffer ();
+   if (mbxhandle)
+   {
+      DPRINT("FOE_send_busy\n");
+      while (entire > UINT16_MAX)
+      {
+         done >>= 1;
+         entire >>= 1;
+      }
+      foembx = (_FOE *) &MBX[mbxhandle * ESC_MBXSIZE];
+      foembx->mbxheader.length = htoes (ESC_FOEHSIZE);
+      foembx->mbxheader.mbxtype = MBXFOE;
+      foembx->foeheader.opcode = FOE_OP_BUSY;
+      foembx->foeheader.busy.done = htoes ((uint16_t)done);
+      foembx->foeheader.busy.entire = htoes ((uint16_t)entire);
+      ESC_mbxpost (mbxhandle);
+      return 0;
+   }
+   else
+   {
+      DPRINT("ERROR:FOE_send_busy\n");
+      return FOE_ERR_PROGERROR;
+   }
+}
+
 /* Handlers for various FoE states. */
 
-#ifdef FOE_READ_SUPPORTED
 /** FoE read request handler. Starts with Initialize, Open and Sending one frame.
  * When first frame have been sent we will send data from Ack.
  * On error we will send FOE Abort.
@@ -340,7 +606,11 @@ static void FOE_read ()
        * Attempt to send the packet
        */
       res = FOE_send_data_packet ();
-      if (res <= ESC_FOE_DATA_SIZE)
+      if (res < ESC_FOE_DATA_SIZE)
+      {
+         FOEvar.foestate = FOE_WAIT_FOR_FINAL_ACK;
+      }
+      else if (res == ESC_FOE_DATA_SIZE)
       {
          FOEvar.foestate = FOE_WAIT_FOR_ACK;
       }
@@ -379,12 +649,11 @@ static void FOE_ack ()
    {
       FOEvar.foestate = FOE_WAIT_FOR_FINAL_ACK;
    }
-   else if (res >= FOE_ERR_NOTDEFINED)
+   else if (res > ESC_FOE_DATA_SIZE)
    {
-      FOE_abort (FOE_ERR_PROGERROR);
+      FOE_abort (res);
    }
 }
-#endif
 
 /** FoE write request handler. Starts with Initialize, Open and Ack that we can/will
  * receive data. On error we will send FOE Abort.
@@ -429,7 +698,9 @@ static void FOE_write ()
    }
 }
 /** FoE data request handler. Validates and reads data until we're finished. Every
- * read frame followed by an Ack frame. On error we will send FOE Abort.
+ * read frame followed by an Ack frame. While both file buffers are busy the
+ * frame is answered with Busy, the master repeats it and we continue after the
+ * data already taken. On error we will send FOE Abort.
  *
  */
 static void FOE_data ()
@@ -439,7 +710,8 @@ static void FOE_data ()
    uint32_t data_len, ncopied;
    uint32_t res;
 
-   if(FOEvar.foestate != FOE_WAIT_FOR_DATA)
+   if ((FOEvar.foestate != FOE_WAIT_FOR_DATA) &&
+       (FOEvar.foestate != FOE_WAIT_FOR_BUFFER))
    {
       FOE_abort(FOE_ERR_ILLEGAL);
       return;
@@ -449,65 +721,81 @@ static void FOE_data ()
    data_len = etohs(foembx->mbxheader.length) - ESC_FOEHSIZE;
    packet = etohl(foembx->foeheader.packetnumber);
 
-   if (packet != FOEvar.foepacket)
+   if ((packet != FOEvar.foepacket) || (FOEvar.fpacketpos > data_len))
    {
       DPRINT("FOE_data packet error, packet: %"PRIu32", foeheader.packet: %"PRIu32"\n",
             packet,
             FOEvar.foepacket);
       FOE_abort (FOE_ERR_PACKETNO);
+      return;
    }
-   else if (data_len == 0)
-   {
-      DPRINT("FOE_data completed\n");
-      FOE_fclose ();
-      res = FOE_send_ack ();
-      FOE_init ();
-   }
-   else if (FOEvar.fposition + data_len > FOEvar.fend)
+   else if (FOEvar.fposition + (data_len - FOEvar.fpacketpos) > FOEvar.fend)
    {
       DPRINT("FOE_data disk full\n");
       FOE_abort (FOE_ERR_DISKFULL);
+      return;
    }
-   else
+
+   if (FOEvar.fpacketpos < data_len)
+   {
+      ncopied = FOE_fwrite (&foembx->data[FOEvar.fpacketpos],
+                            data_len - FOEvar.fpacketpos);
+      FOEvar.fpacketpos = (uint16_t)(FOEvar.fpacketpos + ncopied);
+   }
+
+   if (FOEvar.fwriteerror)
+   {
+      DPRINT("FOE_data write failed\n");
+      FOE_abort (FOE_ERR_PROGERROR);
+   }
+   else if (FOEvar.fpacketpos < data_len)
    {
-      ncopied = FOE_fwrite (foembx->data, data_len);
-      if (!ncopied)
+      DPRINT("FOE_data only %"PRIu16" of %"PRIu32" copied, busy\n",
+            FOEvar.fpacketpos, data_len);
+      FOEvar.foestate = FOE_WAIT_FOR_BUFFER;
+      res = FOE_send_busy ();
+      if (res)
       {
-         DPRINT("FOE_data no copied\n");
-         FOE_abort (FOE_ERR_PROGERROR);
+         FOE_abort (res);
       }
-      else if (data_len == ESC_FOE_DATA_SIZE)
+   }
+   else if (data_len == ESC_FOE_DATA_SIZE_RX)
+   {
+      DPRINT("FOE_data data_len == FOE_DATA_SIZE\n");
+      FOEvar.fpacketpos = 0;
+      FOEvar.foestate = FOE_WAIT_FOR_DATA;
+      res = FOE_send_ack ();
+      if (res)
       {
-         DPRINT("FOE_data data_len == FOE_DATA_SIZE\n");
-         if (ncopied != data_len)
-         {
-            DPRINT("FOE_data only %"PRIu32" of %"PRIu32" copied\n",ncopied, data_len);
-            FOE_abort (FOE_ERR_PROGERROR);
-         }
-         res = FOE_send_ack ();
+         FOE_abort (res);
+      }
+   }
+   else
+   {
+      res = FOE_fclose ();
+      if (res == FOE_PENDING)
+      {
+         FOEvar.foestate = FOE_WAIT_FOR_BUFFER;
+         res = FOE_send_busy ();
          if (res)
          {
             FOE_abort (res);
          }
       }
+      else if (res)
+      {
+         DPRINT("FOE_fclose failed\n");
+         FOE_abort (res);
+      }
       else
       {
-         if ((ncopied != data_len) || FOE_fclose ())
-         {
-            DPRINT("FOE_fclose failed to write extra buffer\n");
-            FOE_abort (FOE_ERR_PROGERROR);
-         }
-         else
-         {
-            DPRINT("FOE_data completed\n");
-            res = FOE_send_ack ();
-            FOE_init ();
-         }
+         DPRINT("FOE_data completed\n");
+         res = FOE_send_ack ();
+         FOE_init ();
       }
    }
 }
 
-#ifdef FOE_READ_SUPPORTED
 /** FoE read request busy handler. Send an Ack of last frame again. On error
  * we will send FOE Abort.
  *
@@ -527,7 +815,6 @@ static void FOE_busy ()
       FOE_ack ();
    }
 }
-#endif
 
 /** FoE error requesthandler. Send an FOE Abort.
  *
@@ -539,14 +826,40 @@ static void FOE_error ()
 }
 
 /** Function copying the application configuration variable
- * to the FoE module local pointer variable.
+ * to the FoE module local pointer variable and hashing the file names
+ * for the lookup in FOE_fopen.
  *
  * @param[in] cfg       = Pointer to by the Application static declared
  * configuration variable holding application specific details.
  */
 void FOE_config (foe_cfg_t * cfg)
 {
+   uint32_t i;
+
    foe_cfg = cfg;
+   for (i = 0; i < foe_cfg->n_files; i++)
+   {
+      foe_cfg->files[i].name_hash = FOE_hash (foe_cfg->files[i].name);
+   }
+}
+
+/** Function called by the application when a write started by
+ * write_async_function has finished. It may be called from an interrupt or
+ * another thread, the FoE transfer resumes when the master repeats the data
+ * frame answered with Busy. Only one write is in progress at a time, also
+ * for files with their own buffers. The result of a write started before
+ * the transfer was aborted is ignored, it only frees the buffer.
+ *
+ * @param[in] result    = 0= on success, else failed
+ */
+void FOE_write_done (uint32_t result)
+{
+   if (result && (CC_ATOMIC_GET (FOEvar.fwritegeneration) ==
+                  CC_ATOMIC_GET (FOEvar.fgeneration)))
+   {
+      FOEvar.fwriteerror = result;
+   }
+   CC_ATOMIC_SET (FOEvar.fwritebusy, 0);
 }
 
 /** Main FoE function checking the status on current mailbox buffers carrying
@@ -595,7 +908,6 @@ void ESC_foeprocess (void)
                FOE_data ();
                break;
             }
-#ifdef FOE_READ_SUPPORTED
             case FOE_OP_RRQ:
             {
                DPRINT("FOE_OP_RRQ\n");
@@ -615,7 +927,6 @@ void ESC_foeprocess (void)
                FOE_busy ();
                break;
             }
-#endif
             case FOE_OP_ERR:
             {
                DPRINT("FOE_OP_ERR\n");
@@ -35,20 +35,63 @@ struct foe_file_cfg
    uint8_t        write_only_in_boot;
    /** for feature use */
    uint32_t       padding:24;
+   /** Optional buffer for this file, used instead of fbuffer and fbuffer2
+    * of foe_cfg_t. NULL if not used
+    */
+   uint8_t *      fbuffer;
+   /** Optional second buffer of buffer_size for this file. NULL if not used */
+   uint8_t *      fbuffer2;
+   /** Buffer size of this file before we flush to destination */
+   uint32_t       buffer_size;
+   /** Hash of name, calculated by FOE_config */
+   uint32_t       name_hash;
+   /** CRC32 of the data received so far, complete when close_function is
+    * called. Requires USE_FOE_CRC32
+    */
+   uint32_t       crc32;
    /** Pointer to application foe write function */
    uint32_t       (*write_function) (foe_file_cfg_t * self, uint8_t * data, size_t length);
+   /** Optional pointer to application foe write function that only starts the
+    * write and reports completion with FOE_write_done. The data must be kept
+    * until then, address_offset is advanced when the function returns.
+    * Used instead of write_function when fbuffer2 is set. A write still in
+    * progress when the transfer is aborted must be finished and reported
+    * as well, its result is ignored and close_function isn't called for
+    * the aborted file.
+    */
+   uint32_t       (*write_async_function) (foe_file_cfg_t * self, uint8_t * data, size_t length);
+   /** Pointer to application foe read function, filling the mailbox data
+    * directly with up to length bytes from address_offset. Returns the number
+    * of bytes read, less than length at end of file, or an FOE_ERR_ code.
+    * NULL if the file can't be read.
+    */
+   uint32_t       (*read_function) (foe_file_cfg_t * self, uint8_t * data, size_t length);
+   /** Optional pointer to application foe close function, called when the
+    * file is received and written. Returns 0 or an FOE_ERR_ code, ex.
+    * FOE_ERR_CHECKSUM if crc32 doesn't match. NULL if not used
+    */
+   uint32_t       (*close_function) (foe_file_cfg_t * self);
 };
 
 typedef struct foe_cfg
 {
    /** Allocate static in caller func to fit buffer_size */
    uint8_t * fbuffer;
+   /** Optional second buffer of buffer_size, filled while fbuffer is written
+    * by write_async_function. NULL if not used
+    */
+   uint8_t * fbuffer2;
    /** Buffer size before we flush to destination */
    uint32_t  buffer_size;
    /** Number of files used in firmware update */
    uint32_t  n_files;
    /** Pointer to files configured to be used by FoE */
    foe_file_cfg_t * files;
+   /** Optional pointer to CRC32 function, ex. using a hardware CRC unit.
+    * Continues crc, the CRC32 of previous data, over data. NULL to use the
+    * table driven software function
+    */
+   uint32_t  (*crc32_function) (uint32_t crc, const uint8_t * data, size_t length);
 } foe_cfg_t;
 
 typedef struct CC_PACKED
@@ -58,7 +101,7 @@ typedef struct CC_PACKED
    /** Current file buffer position, evaluated against foe file buffer size
     * when to flush
     */
-   uint16_t fbufposition;
+   uint32_t fbufposition;
    /** Frame number in read or write sequence */
    uint32_t foepacket;
    /** Current position in file to be handled by FoE request */
@@ -67,11 +110,28 @@ typedef struct CC_PACKED
    uint32_t fprevposition;
    /** End position of allocated disk space for FoE requested file  */
    uint32_t fend;
+   /** Data of the current mailbox already written, while waiting for a
+    * free file buffer
+    */
+   uint16_t fpacketpos;
+   /** Index of the file buffer being filled */
+   uint8_t  fbufindex;
+   /** Asynchronous write of the other file buffer in progress */
+   uint8_t  fwritebusy;
+   /** Transfer number, counted up by FOE_init */
+   uint8_t  fgeneration;
+   /** Transfer number of the asynchronous write in progress */
+   uint8_t  fwritegeneration;
+   /** Last file buffer handed over on close */
+   uint8_t  fclosed;
+   /** First error returned by the application write functions */
+   uint32_t fwriteerror;
 } _FOEvar;
 
 /* Initializes FoE state. */
 void FOE_config (foe_cfg_t * cfg);
 void FOE_init (void);
 void ESC_foeprocess (void);
+void FOE_write_done (uint32_t result);
 
 #endif
@@ -0,0 +1,306 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+ /** \file
+ * \brief
+ * Latency and jitter instrumentation.
+ *
+ * Instrumented process data code in the stack records its entry timestamp
+ * and duration in a single producer, single consumer ring buffer that may be
+ * drained by an application thread. The mailbox may be handled in another
+ * context, ex. a worker thread next to an interrupt thread, so its probe
+ * only updates stats of its own. Min/max/histogram stats are kept of the
+ * latencies from SM2 and SYNC0 events to process data handled, and are
+ * exposed in the calc and copy time and error counter sub-indexes of the
+ * SyncManager parameter objects 0x1C32/0x1C33.
+ */
+#include <string.h>
+#include "esc.h"
+#include "esc_coe.h"
+#include "esc_stats.h"
+
+#if (ESC_STATS_RING_SIZE & (ESC_STATS_RING_SIZE - 1)) != 0
+#error "ESC_STATS_RING_SIZE must be a power of two"
+#endif
+
+#define STATS_SUB_CALC_COPY_TIME       0x06
+#define STATS_SUB_SM_EVENT_MISSED      0x0B
+#define STATS_SUB_CYCLE_TOO_SMALL      0x0C
+#define STATS_SUB_MIN_CYCLE_DIST       0x0F
+#define STATS_SUB_MAX_CYCLE_DIST       0x10
+
+static esc_stats_record_t ring[ESC_STATS_RING_SIZE];
+/* Written by the stack only */
+static volatile uint32_t ring_head;
+/* Written by the reader only */
+static volatile uint32_t ring_tail;
+
+static esc_stats_t stats;
+
+/* Latency measurement state, timestamps valid when the flag is set */
+static uint32_t sm2_time;
+static uint32_t sync0_time;
+static uint32_t inputs_time;
+static uint8_t sm2_pending;
+static uint8_t sm2_seen;
+static uint8_t sync0_valid;
+static uint8_t cycle_valid;
+static uint8_t inputs_valid;
+
+/* floor(log2(value)) limited to the number of bins */
+static uint8_t stats_bin (uint32_t value)
+{
+   uint8_t bin = 0;
+
+   if (value >= 0x10000U)
+   {
+      value >>= 16;
+      bin += 16;
+   }
+   if (value >= 0x100U)
+   {
+      value >>= 8;
+      bin += 8;
+   }
+   if (value >= 0x10U)
+   {
+      value >>= 4;
+      bin += 4;
+   }
+   if (value >= 0x4U)
+   {
+      value >>= 2;
+      bin += 2;
+   }
+   if (value >= 0x2U)
+   {
+      bin += 1;
+   }
+   return (uint8_t)MIN (bin, ESC_STATS_HIST_BINS - 1);
+}
+
+static void stats_latency (esc_stats_latency_t * latency, uint32_t value)
+{
+   if ((latency->count == 0) || (value < latency->min))
+   {
+      latency->min = value;
+   }
+   if (value > latency->max)
+   {
+      latency->max = value;
+   }
+   latency->count++;
+   latency->hist[stats_bin (value)]++;
+}
+
+uint32_t ESC_stats_time (void)
+{
+   if (ESCvar.get_timestamp == NULL)
+   {
+      return 0;
+   }
+   return (ESCvar.get_timestamp) ();
+}
+
+void ESC_stats_probe (uint8_t point, uint32_t start)
+{
+   uint32_t now;
+   uint32_t head;
+
+   if (ESCvar.get_timestamp == NULL)
+   {
+      return;
+   }
+   now = (ESCvar.get_timestamp) ();
+
+   if (point == ESC_STATS_MBXPROCESS)
+   {
+      stats_latency (&stats.mbxprocess, now - start);
+      return;
+   }
+
+   head = CC_ATOMIC_GET(ring_head);
+   if ((head - CC_ATOMIC_GET(ring_tail)) < ESC_STATS_RING_SIZE)
+   {
+      esc_stats_record_t * record = &ring[head & (ESC_STATS_RING_SIZE - 1)];
+
+      record->start = start;
+      record->duration = now - start;
+      record->point = point;
+      CC_ATOMIC_SET(ring_head, head + 1);
+   }
+   else
+   {
+      stats.overruns++;
+   }
+
+   switch (point)
+   {
+      case ESC_STATS_SET_OUTPUTS:
+         if (sm2_pending)
+         {
+            stats_latency (&stats.outputs_copy, now - sm2_time);
+         }
+         if (sync0_valid)
+         {
+            stats_latency (&stats.sync0_to_outputs, now - sync0_time);
+         }
+         break;
+      case ESC_STATS_GET_INPUTS:
+         inputs_time = start;
+         inputs_valid = 1;
+         break;
+      case ESC_STATS_TXPDO_UPDATE:
+         if (inputs_valid)
+         {
+            stats_latency (&stats.inputs_copy, now - inputs_time);
+            inputs_valid = 0;
+         }
+         if (sm2_pending)
+         {
+            stats_latency (&stats.sm2_to_inputs, now - sm2_time);
+            sm2_pending = 0;
+         }
+         break;
+      default:
+         break;
+   }
+}
+
+void ESC_stats_sm2 (uint32_t time)
+{
+   if (ESCvar.get_timestamp == NULL)
+   {
+      return;
+   }
+
+   if (cycle_valid)
+   {
+      uint32_t cycle = time - sm2_time;
+
+      if ((stats.min_cycle == 0) || (cycle < stats.min_cycle))
+      {
+         stats.min_cycle = cycle;
+      }
+      if (cycle > stats.max_cycle)
+      {
+         stats.max_cycle = cycle;
+      }
+      /* Inputs of the previous cycle not written yet */
+      if (sm2_pending && (stats.cycle_too_small < UINT16_MAX))
+      {
+         stats.cycle_too_small++;
+      }
+   }
+   sm2_time = time;
+   sm2_pending = 1;
+   sm2_seen = 1;
+   cycle_valid = 1;
+}
+
+void ESC_stats_sync0 (void)
+{
+   if (ESCvar.get_timestamp == NULL)
+   {
+      return;
+   }
+
+   if ((ESCvar.dcsync > 0) && sync0_valid && !sm2_seen &&
+       ((CC_ATOMIC_GET(ESCvar.App.state) & APPSTATE_OUTPUT) > 0) &&
+       (stats.sm_event_missed < UINT16_MAX))
+   {
+      stats.sm_event_missed++;
+   }
+   sync0_time = (ESCvar.get_timestamp) ();
+   sync0_valid = 1;
+   sm2_seen = 0;
+}
+
+unsigned int ESC_stats_read (esc_stats_record_t * records, unsigned int n)
+{
+   uint32_t tail = CC_ATOMIC_GET(ring_tail);
+   uint32_t head = CC_ATOMIC_GET(ring_head);
+   unsigned int count = 0;
+
+   while ((tail != head) && (count < n))
+   {
+      records[count++] = ring[tail & (ESC_STATS_RING_SIZE - 1)];
+      tail++;
+   }
+   CC_ATOMIC_SET(ring_tail, tail);
+   return count;
+}
+
+void ESC_stats_get (esc_stats_t * copy)
+{
+   memcpy (copy, &stats, sizeof (stats));
+}
+
+void ESC_stats_reset (void)
+{
+   memset (&stats, 0, sizeof (stats));
+   sm2_pending = 0;
+   sm2_seen = 0;
+   sync0_valid = 0;
+   cycle_valid = 0;
+   inputs_valid = 0;
+   CC_ATOMIC_SET(ring_tail, CC_ATOMIC_GET(ring_head));
+}
+
+/* Set a sub-index with dynamic data, saturating to its size */
+static void stats_set (int32_t nidx, uint8_t subindex, uint32_t value)
+{
+   const _objd * objd;
+   int16_t nsub;
+
+   nsub = SDO_findsubindex (nidx, subindex);
+   if (nsub < 0)
+   {
+      return;
+   }
+   objd = &SDOobjects[nidx].objdesc[nsub];
+   if (objd->data == NULL)
+   {
+      return;
+   }
+   if (objd->bitlength == 16)
+   {
+      *(uint16_t *)objd->data = (uint16_t)MIN (value, UINT16_MAX);
+   }
+   else if (objd->bitlength == 32)
+   {
+      *(uint32_t *)objd->data = value;
+   }
+}
+
+void ESC_stats_upload (uint16_t index)
+{
+   const esc_stats_latency_t * copy_time;
+   int32_t nidx;
+
+   if (index == 0x1C32)
+   {
+      copy_time = &stats.outputs_copy;
+   }
+   else if (index == 0x1C33)
+   {
+      copy_time = &stats.inputs_copy;
+   }
+   else
+   {
+      return;
+   }
+
+   nidx = SDO_findobject (index);
+   if (nidx < 0)
+   {
+      return;
+   }
+   stats_set (nidx, STATS_SUB_CALC_COPY_TIME, copy_time->max);
+   stats_set (nidx, STATS_SUB_SM_EVENT_MISSED, stats.sm_event_missed);
+   stats_set (nidx, STATS_SUB_CYCLE_TOO_SMALL, stats.cycle_too_small);
+   stats_set (nidx, STATS_SUB_MIN_CYCLE_DIST, stats.min_cycle);
+   stats_set (nidx, STATS_SUB_MAX_CYCLE_DIST, stats.max_cycle);
+}
@@ -0,0 +1,137 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+ /** \file
+ * \brief
+ * Headerfile for esc_stats.c
+ */
+
+#ifndef __esc_stats__
+#define __esc_stats__
+
+#include <cc.h>
+#include "options.h"
+
+/** Instrumented code, one record is made each time it returns */
+typedef enum
+{
+   ESC_STATS_DIG_PROCESS,
+   ESC_STATS_RXPDO_UPDATE,
+   ESC_STATS_TXPDO_UPDATE,
+   /** cb_set_outputs, or the publish of the outputs if USE_TRIPLE_BUFFER */
+   ESC_STATS_SET_OUTPUTS,
+   /** cb_get_inputs, or the take of the inputs if USE_TRIPLE_BUFFER */
+   ESC_STATS_GET_INPUTS,
+   /** Kept in esc_stats_t.mbxprocess only, not recorded in the ring buffer */
+   ESC_STATS_MBXPROCESS,
+   ESC_STATS_POINTS
+} esc_stats_point_t;
+
+typedef struct
+{
+   /** Timestamp when entered, in ns */
+   uint32_t start;
+   /** Time spent, in ns */
+   uint32_t duration;
+   /** esc_stats_point_t */
+   uint8_t point;
+} esc_stats_record_t;
+
+typedef struct
+{
+   uint32_t count;
+   uint32_t min;
+   uint32_t max;
+   /** Bin n counts latencies in [2^n, 2^(n+1)) ns, bin 0 also counts 0 */
+   uint32_t hist[ESC_STATS_HIST_BINS];
+} esc_stats_latency_t;
+
+typedef struct
+{
+   /** SYNC0 event to outputs handed to the application */
+   esc_stats_latency_t sync0_to_outputs;
+   /** SM2 event to inputs written to SM3 */
+   esc_stats_latency_t sm2_to_inputs;
+   /** SM2 event to outputs handed to the application, 0x1C32:06 */
+   esc_stats_latency_t outputs_copy;
+   /** Inputs fetched from the application to written to SM3, 0x1C33:06 */
+   esc_stats_latency_t inputs_copy;
+   /** Time spent in ESC_mbxprocess, updated by the mailbox context only */
+   esc_stats_latency_t mbxprocess;
+   /** Min and max time between SM2 events, 0x1C3x:0F and 0x1C3x:10 */
+   uint32_t min_cycle;
+   uint32_t max_cycle;
+   /** SYNC0 events without a preceding SM2 event in OP, 0x1C3x:0B */
+   uint16_t sm_event_missed;
+   /** SM2 events before the inputs of the previous one were written,
+    * 0x1C3x:0C
+    */
+   uint16_t cycle_too_small;
+   /** Records dropped due to a full ring buffer */
+   uint32_t overruns;
+} esc_stats_t;
+
+#if USE_STATS
+#define ESC_STATS_TIME()                  ESC_stats_time ()
+#define ESC_STATS_PROBE(point, start)     ESC_stats_probe (point, start)
+#define ESC_STATS_SM2(time)               ESC_stats_sm2 (time)
+#define ESC_STATS_SYNC0()                 ESC_stats_sync0 ()
+#else
+#define ESC_STATS_TIME()                  0
+#define ESC_STATS_PROBE(point, start)     ((void)(start))
+#define ESC_STATS_SM2(time)               ((void)(time))
+#define ESC_STATS_SYNC0()
+#endif
+
+/** Get a timestamp from the get_timestamp hook.
+ *
+ * @return timestamp in ns, 0 if no hook is configured
+ */
+uint32_t ESC_stats_time (void);
+
+/** Record a return from instrumented code and update the latency stats.
+ *
+ * @param[in]   point   = esc_stats_point_t of the instrumented code
+ * @param[in]   start   = timestamp taken when entered
+ */
+void ESC_stats_probe (uint8_t point, uint32_t start);
+
+/** Mark the SM2 event as observed by the stack.
+ *
+ * @param[in]   time    = timestamp of the observation
+ */
+void ESC_stats_sm2 (uint32_t time);
+
+/** Mark a SYNC0 event, called by the HAL SYNC0 handler.
+ */
+void ESC_stats_sync0 (void);
+
+/** Fetch records from the ring buffer. There may be one reader, running
+ * concurrently with the stack.
+ *
+ * @param[out]  records = buffer to copy records to
+ * @param[in]   n       = max number of records to fetch
+ * @return number of records fetched
+ */
+unsigned int ESC_stats_read (esc_stats_record_t * records, unsigned int n);
+
+/** Copy the current stats. Values updated while copying may be torn.
+ *
+ * @param[out]  stats   = destination
+ */
+void ESC_stats_get (esc_stats_t * stats);
+
+/** Clear stats and ring buffer.
+ */
+void ESC_stats_reset (void);
+
+/** Update the calc and copy time, cycle distance and error counter
+ * sub-indexes of 0x1C32/0x1C33 in the object dictionary before upload.
+ *
+ * @param[in]   index   = index of the object about to be uploaded
+ */
+void ESC_stats_upload (uint16_t index);
+
+#endif
@@ -0,0 +1,384 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+ /** \file
+ * \brief
+ * Interrupt driven operation of the slave stack on Linux.
+ *
+ * The ESC IRQ is waited for on a file descriptor, a gpiochip line event, a
+ * UIO device or an eventfd. A high priority thread serves SM2/SM3 and SYNC0
+ * with DIG_process and defers the remaining events to a lower priority
+ * worker thread running ecat_slv_worker, the same split as the ecat_isr and
+ * isr_run tasks of the rt-kernel XMC4 HAL.
+ *
+ * The HAL must serialize ESC_read/ESC_write since both threads access the
+ * ESC, and refresh ESCvar.ALevent on every access.
+ */
+#include "esc.h"
+#include "esc_irq.h"
+#include "ecat_slv.h"
+#include "esc_stats.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#define ESC_IRQ_SYNC0_STATUS     0x098E
+
+/* Events deferred to the worker thread */
+#define ESC_IRQ_WORKER_EVENTS    (ESCREG_ALEVENT_CONTROL | \
+                                  ESCREG_ALEVENT_SMCHANGE | \
+                                  ESCREG_ALEVENT_SM0 | \
+                                  ESCREG_ALEVENT_SM1 | \
+                                  ESCREG_ALEVENT_EEP)
+
+/* Events served by the interrupt thread */
+#define ESC_IRQ_EVENTS           (ESCREG_ALEVENT_SM2 | \
+                                  ESCREG_ALEVENT_SM3 | \
+                                  ESCREG_ALEVENT_DC_SYNC0 | \
+                                  ESCREG_ALEVENT_WD | \
+                                  ESC_IRQ_WORKER_EVENTS)
+
+static esc_irq_source_t irq_source;
+static int irq_fd = -1;
+static int stop_fd = -1;
+static volatile int running;
+static sem_t worker_sem;
+static pthread_t isr_thread;
+static pthread_t worker_thread;
+
+/* Open the interrupt source, returns the fd to wait on or -1 */
+static int esc_irq_open (const esc_irq_cfg_t * cfg)
+{
+   int fd;
+
+   switch (cfg->source)
+   {
+      case ESC_IRQ_GPIO:
+      {
+         struct gpio_v2_line_request req;
+         int chip = open (cfg->device, O_RDONLY | O_CLOEXEC);
+
+         if (chip < 0)
+         {
+            return -1;
+         }
+         memset (&req, 0, sizeof (req));
+         req.offsets[0] = cfg->line;
+         req.num_lines = 1;
+         /* IRQ pin is configured push-pull active high by the HAL */
+         req.config.flags = GPIO_V2_LINE_FLAG_INPUT |
+                            GPIO_V2_LINE_FLAG_EDGE_RISING;
+         strncpy (req.consumer, "soes", sizeof (req.consumer) - 1);
+         fd = (ioctl (chip, GPIO_V2_GET_LINE_IOCTL, &req) < 0) ? -1 : req.fd;
+         close (chip);
+         return fd;
+      }
+      case ESC_IRQ_UIO:
+         return open (cfg->device, O_RDWR | O_CLOEXEC);
+      case ESC_IRQ_EVENTFD:
+         return cfg->fd;
+      default:
+         return -1;
+   }
+}
+
+/* Re-arm the interrupt source, UIO disables the IRQ when it fires */
+static void esc_irq_arm (void)
+{
+   if (irq_source == ESC_IRQ_UIO)
+   {
+      int32_t enable = 1;
+
+      if (write (irq_fd, &enable, sizeof (enable)) != sizeof (enable))
+      {
+         DPRINT ("Failed to enable UIO interrupt\n");
+      }
+   }
+}
+
+/* Wait for the interrupt and consume it, returns 0 when stopped */
+static int esc_irq_wait (void)
+{
+   struct pollfd fds[2];
+   union
+   {
+      struct gpio_v2_line_event line;
+      int32_t count;
+      uint64_t value;
+   } event;
+
+   fds[0].fd = irq_fd;
+   fds[0].events = POLLIN;
+   fds[1].fd = stop_fd;
+   fds[1].events = POLLIN;
+
+   while (running)
+   {
+      if (poll (fds, 2, -1) < 0)
+      {
+         if (errno != EINTR)
+         {
+            return 0;
+         }
+         continue;
+      }
+      if (fds[1].revents != 0)
+      {
+         return 0;
+      }
+      if (fds[0].revents & POLLIN)
+      {
+         size_t size = sizeof (event.value);
+
+         if (irq_source == ESC_IRQ_GPIO)
+         {
+            size = sizeof (event.line);
+         }
+         else if (irq_source == ESC_IRQ_UIO)
+         {
+            size = sizeof (event.count);
+         }
+         if (read (irq_fd, &event, size) == (ssize_t)size)
+         {
+            return 1;
+         }
+      }
+      else if (fds[0].revents != 0)
+      {
+         return 0;
+      }
+   }
+   return 0;
+}
+
+/* SYNC0 handler */
+static void esc_irq_sync0 (void)
+{
+   uint8_t ack;
+
+   ESC_STATS_SYNC0();
+
+   /* Subtract the sync counter to check the pace compared to the SM IRQ */
+   if((CC_ATOMIC_GET(ESCvar.App.state) & APPSTATE_OUTPUT) > 0)
+   {
+      CC_ATOMIC_SUB(ESCvar.synccounter, 1);
+   }
+   /* Check so we're inside the limit */
+   if((CC_ATOMIC_GET(ESCvar.synccounter) < -ESCvar.synccounterlimit) ||
+          (CC_ATOMIC_GET(ESCvar.synccounter) > ESCvar.synccounterlimit))
+   {
+      if((CC_ATOMIC_GET(ESCvar.App.state) & APPSTATE_OUTPUT) > 0)
+      {
+         DPRINT("sync error = %d\n", ESCvar.synccounter);
+         ESC_ALstatusgotoerror((ESCsafeop | ESCerror), ALERR_SYNCERROR);
+         CC_ATOMIC_SET(ESCvar.synccounter, 0);
+      }
+   }
+   DIG_process(DIG_PROCESS_APP_HOOK_FLAG | DIG_PROCESS_INPUTS_FLAG);
+   /* Ack the SYNC0 IRQ */
+   ESC_read (ESC_IRQ_SYNC0_STATUS, &ack, sizeof (ack));
+}
+
+/* Serve the pending events, returns the events found pending */
+static uint32_t esc_irq_handler (void)
+{
+   uint32_t mask;
+   uint32_t pending;
+
+   /* The HAL refreshes ESCvar.ALevent on the mask read */
+   mask = ESC_ALeventmaskread ();
+   pending = CC_ATOMIC_GET(ESCvar.ALevent) & mask;
+
+   /* Handle SM2 & SM3 interrupt */
+   if(pending & (ESCREG_ALEVENT_SM2 | ESCREG_ALEVENT_SM3))
+   {
+      /* Is DC active or not */
+      if(ESCvar.dcsync == 0)
+      {
+         DIG_process(DIG_PROCESS_OUTPUTS_FLAG | DIG_PROCESS_APP_HOOK_FLAG |
+               DIG_PROCESS_INPUTS_FLAG);
+      }
+      else
+      {
+         /* Add the sync counter to check the pace compared to the SM IRQ */
+         if((CC_ATOMIC_GET(ESCvar.App.state) & APPSTATE_OUTPUT) > 0)
+         {
+            CC_ATOMIC_ADD(ESCvar.synccounter, 1);
+         }
+         DIG_process(DIG_PROCESS_OUTPUTS_FLAG);
+      }
+   }
+
+   if(pending & ESCREG_ALEVENT_DC_SYNC0)
+   {
+      esc_irq_sync0 ();
+   }
+
+   /* Handle low prio interrupts */
+   if(pending & ESC_IRQ_WORKER_EVENTS)
+   {
+      /* Mask interrupts while servicing them */
+      mask &= ~(uint32_t)ESC_IRQ_WORKER_EVENTS;
+      ESC_ALeventmaskwrite (mask);
+      sem_post (&worker_sem);
+   }
+
+   /* SM watchdog */
+   if(pending & ESCREG_ALEVENT_WD)
+   {
+      uint16_t wd;
+      /* Ack the WD IRQ */
+      ESC_read (ESCREG_WDSTATUS, &wd, sizeof (wd));
+      wd = etohs (wd);
+      /* Check if the WD have expired and if we're in OP */
+      if(((wd & 0x1) == 0)  &&
+         ((CC_ATOMIC_GET(ESCvar.App.state) & APPSTATE_OUTPUT) > 0))
+      {
+         ESC_ALstatusgotoerror((ESCsafeop | ESCerror), ALERR_WATCHDOG);
+         ESC_ALeventmaskwrite (mask & ~(uint32_t)ESCREG_ALEVENT_WD);
+      }
+   }
+
+   return pending;
+}
+
+static void * esc_irq_isr_run (void * arg)
+{
+   /* Serve events pending before the first edge */
+   do
+   {
+      while (esc_irq_handler () & ESC_IRQ_EVENTS);
+      esc_irq_arm ();
+   } while (esc_irq_wait ());
+
+   return NULL;
+}
+
+/* Function for low prio ESC interrupts */
+static void * esc_irq_worker_run (void * arg)
+{
+   while (1)
+   {
+      while ((sem_wait (&worker_sem) < 0) && (errno == EINTR));
+      if (!running)
+      {
+         break;
+      }
+      /* Update time, used by the mailbox and emulated eeprom handlers */
+      ESC_read (ESCREG_LOCALTIME, (void *) &ESCvar.Time, sizeof (ESCvar.Time));
+      ESCvar.Time = etohl (ESCvar.Time);
+      ecat_slv_worker (ESC_IRQ_WORKER_EVENTS);
+   }
+   return NULL;
+}
+
+/* Create a thread, with SCHED_FIFO if a priority is given */
+static int esc_irq_thread (pthread_t * thread, void * (*run) (void *),
+                           int priority)
+{
+   pthread_attr_t attr;
+   struct sched_param param;
+   int result;
+
+   pthread_attr_init (&attr);
+   if (priority > 0)
+   {
+      memset (&param, 0, sizeof (param));
+      param.sched_priority = priority;
+      pthread_attr_setinheritsched (&attr, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy (&attr, SCHED_FIFO);
+      pthread_attr_setschedparam (&attr, &param);
+   }
+   result = pthread_create (thread, &attr, run, NULL);
+   if ((result == EPERM) && (priority > 0))
+   {
+      DPRINT ("No permission for SCHED_FIFO, using default scheduling\n");
+      result = pthread_create (thread, NULL, run, NULL);
+   }
+   pthread_attr_destroy (&attr);
+   return result;
+}
+
+int ESC_irq_start (const esc_irq_cfg_t * cfg)
+{
+   irq_source = cfg->source;
+   irq_fd = esc_irq_open (cfg);
+   if (irq_fd < 0)
+   {
+      DPRINT ("Failed to open ESC interrupt source\n");
+      return -1;
+   }
+   stop_fd = eventfd (0, EFD_CLOEXEC);
+   if ((stop_fd < 0) || (sem_init (&worker_sem, 0, 0) != 0))
+   {
+      goto err_close;
+   }
+
+   running = 1;
+   if (esc_irq_thread (&worker_thread, esc_irq_worker_run,
+                       cfg->worker_priority) != 0)
+   {
+      goto err_sem;
+   }
+   if (esc_irq_thread (&isr_thread, esc_irq_isr_run, cfg->isr_priority) != 0)
+   {
+      running = 0;
+      sem_post (&worker_sem);
+      pthread_join (worker_thread, NULL);
+      goto err_sem;
+   }
+   return 0;
+
+err_sem:
+   running = 0;
+   sem_destroy (&worker_sem);
+err_close:
+   if (stop_fd >= 0)
+   {
+      close (stop_fd);
+      stop_fd = -1;
+   }
+   if (irq_source != ESC_IRQ_EVENTFD)
+   {
+      close (irq_fd);
+   }
+   irq_fd = -1;
+   return -1;
+}
+
+void ESC_irq_stop (void)
+{
+   uint64_t stop = 1;
+
+   if (!running)
+   {
+      return;
+   }
+   running = 0;
+   if (write (stop_fd, &stop, sizeof (stop)) != sizeof (stop))
+   {
+      DPRINT ("Failed to signal ESC interrupt thread\n");
+   }
+   pthread_join (isr_thread, NULL);
+   sem_post (&worker_sem);
+   pthread_join (worker_thread, NULL);
+
+   sem_destroy (&worker_sem);
+   close (stop_fd);
+   stop_fd = -1;
+   if (irq_source != ESC_IRQ_EVENTFD)
+   {
+      close (irq_fd);
+   }
+   irq_fd = -1;
+}
@@ -0,0 +1,63 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+ /** \file
+ * \brief
+ * Interrupt driven operation of the slave stack on Linux.
+ */
+
+#ifndef __esc_irq__
+#define __esc_irq__
+
+#include <cc.h>
+
+/** Source of the ESC interrupt */
+typedef enum
+{
+   /** Edge event on a gpiochip line wired to the ESC IRQ pin */
+   ESC_IRQ_GPIO,
+   /** UIO device owning the ESC IRQ */
+   ESC_IRQ_UIO,
+   /** eventfd signalled by the ESC HAL, e.g. the ESC simulator */
+   ESC_IRQ_EVENTFD,
+} esc_irq_source_t;
+
+typedef struct esc_irq_cfg
+{
+   esc_irq_source_t source;
+   /** gpiochip or UIO device, e.g. "/dev/gpiochip0" or "/dev/uio0" */
+   const char * device;
+   /** Line offset on the gpiochip */
+   unsigned int line;
+   /** eventfd to wait on for ESC_IRQ_EVENTFD */
+   int fd;
+   /** SCHED_FIFO priority of the thread running DIG_process, 0 for
+    * default scheduling
+    */
+   int isr_priority;
+   /** SCHED_FIFO priority of the thread running ecat_slv_worker, should be
+    * lower than isr_priority, 0 for default scheduling
+    */
+   int worker_priority;
+} esc_irq_cfg_t;
+
+/** Start the interrupt and worker threads. Call after ecat_slv_init with
+ * use_interrupt set and the HAL interrupt enable/disable functions given
+ * in the stack configuration. The interrupt thread runs DIG_process on
+ * SM2/SM3 and SYNC0 events and defers AL control, SM change, mailbox and
+ * EEPROM events to the worker thread running ecat_slv_worker.
+ *
+ * @param[in]   cfg     = interrupt source and thread priorities
+ * @return 0 on success, -1 if the interrupt source could not be opened or
+ * the threads could not be created.
+ */
+int ESC_irq_start (const esc_irq_cfg_t * cfg);
+
+/** Stop and join the interrupt and worker threads started by
+ * ESC_irq_start.
+ */
+void ESC_irq_stop (void);
+
+#endif
@@ -11,10 +11,14 @@
  * registers and memory.
  */
 #include "esc.h"
+#include "esc_hw.h"
+#include "lan9252.h"
 #include <string.h>
+#include <pthread.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
 
 #define BIT(x)                   (1U << (x))
 
@@ -53,7 +57,35 @@
 #define ESC_RESET_CTRL_REG       0x1F8
 #define ESC_RESET_CTRL_RST       BIT(6)
 
+#define ESC_IRQ_CFG_REG          0x054
+#define ESC_IRQ_CFG_EN           BIT(8)
+#define ESC_IRQ_CFG_POL_HIGH     BIT(4)
+#define ESC_IRQ_CFG_PUSH_PULL    BIT(0)
+#define ESC_INT_EN_REG           0x05C
+#define ESC_INT_EN_ECAT          BIT(0)
+
+/* Largest PRAM transfer, process data or mailbox, plus a command header
+ * and padding to whole 32-bit words
+ */
+#define ESC_PRAM_CMD_SIZE        3
+#define ESC_PRAM_MAX_SIZE        MAX (MAX (MAX_RXPDO_SIZE, MAX_TXPDO_SIZE), \
+                                      MAX (MBXSIZE, MBXSIZEBOOT))
+#define ESC_PRAM_BUF_SIZE        ((ESC_PRAM_CMD_SIZE + ESC_PRAM_MAX_SIZE + 3U + 63U) & ~63U)
+
 static int lan9252 = -1;
+/* Serialize accesses, the stack may run from several threads when
+ * interrupt driven
+ */
+static pthread_mutex_t esc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Preallocated PRAM FIFO transfer buffer */
+static uint8_t pram_buf[ESC_PRAM_BUF_SIZE] __attribute__((aligned (64)));
+
+/* Queued CSR operations, executed by the driver in one ioctl call */
+static struct lan9252_csr_op csr_ops[LAN9252_CSR_BATCH_MAX];
+static void * csr_dest[LAN9252_CSR_BATCH_MAX];
+static unsigned int csr_count;
+static int csr_batch;
 
 /* lan9252 singel write */
 static void lan9252_write_32 (uint16_t address, uint32_t val)
@@ -133,17 +165,137 @@ static void ESC_write_csr (uint16_t address, void *buf, uint16_t len)
    } while(value & ESC_CSR_CMD_BUSY);
 }
 
+/* Execute queued CSR operations and copy read data to the destinations */
+static void ESC_flush_csr (void)
+{
+   struct lan9252_csr_batch batch;
+   unsigned int i;
+
+   if (csr_count == 0)
+   {
+      return;
+   }
+
+   if (csr_batch)
+   {
+      batch.ops = (uint64_t)(uintptr_t)csr_ops;
+      batch.count = csr_count;
+      batch.reserved = 0;
+      if (ioctl (lan9252, LAN9252_CSR_BATCH, &batch) != (int)csr_count)
+      {
+         DPRINT ("CSR batch failed\n");
+      }
+   }
+   else
+   {
+      /* Driver without batch support, one access at the time */
+      for (i = 0; i < csr_count; i++)
+      {
+         if (csr_ops[i].write)
+         {
+            ESC_write_csr (csr_ops[i].address, &csr_ops[i].data,
+                           csr_ops[i].len);
+         }
+         else
+         {
+            ESC_read_csr (csr_ops[i].address, &csr_ops[i].data,
+                          csr_ops[i].len);
+         }
+      }
+   }
+
+   for (i = 0; i < csr_count; i++)
+   {
+      if (!csr_ops[i].write)
+      {
+         memcpy (csr_dest[i], &csr_ops[i].data, csr_ops[i].len);
+      }
+   }
+   csr_count = 0;
+}
+
+/* Queue one CSR operation, read data is copied to buf on flush */
+static void ESC_queue_csr (uint16_t address, void *buf, uint16_t len,
+                           uint8_t write)
+{
+   struct lan9252_csr_op * op;
+
+   if (csr_count == LAN9252_CSR_BATCH_MAX)
+   {
+      ESC_flush_csr ();
+   }
+
+   op = &csr_ops[csr_count];
+   op->address = address;
+   op->len = (uint8_t)len;
+   op->write = write;
+   op->data = 0;
+   if (write)
+   {
+      memcpy (&op->data, buf, len);
+   }
+   csr_dest[csr_count++] = buf;
+}
+
+/* Split a CSR access in valid sizes and queue them */
+static void ESC_queue_csr_access (uint16_t address, void *buf, uint16_t len,
+                                  uint8_t write)
+{
+   uint16_t size;
+   uint8_t *temp_buf = (uint8_t *)buf;
+
+   while(len > 0)
+   {
+      /* We write maximum 4 bytes at the time */
+      size = (len > 4) ? 4 : len;
+      /* Make size aligned to address according to LAN9252 datasheet
+       * Table 12-14 EtherCAT CSR Address VS size and MicroChip SDK code
+       */
+      /* If we got an odd address size is 1 , 01b 11b is captured */
+      if(address & BIT(0))
+      {
+         size = 1;
+      }
+      /* If address 1xb and size != 1 and 3 , allow size 2 else size 1 */
+      else if (address & BIT(1))
+      {
+         size = (size & BIT(0)) ? 1 : 2;
+      }
+      /* size 3 not valid */
+      else if (size == 3)
+      {
+         size = 1;
+      }
+      /* else size is kept AS IS */
+      ESC_queue_csr (address, temp_buf, size, write);
+
+      /* next address */
+      len = (uint16_t)(len - size);
+      temp_buf = (uint8_t *)(temp_buf + size);
+      address = (uint16_t)(address + size);
+   }
+}
+
+/* Queue the AlEvent read done after every access, to mimic the ET1x00
+ * always providing AlEvent on every read or write, and run the batch.
+ */
+static void ESC_flush_alevent (void)
+{
+   uint16_t alevent;
+
+   ESC_queue_csr (ESCREG_ALEVENT, &alevent, sizeof(alevent), 0);
+   ESC_flush_csr ();
+   ESCvar.ALevent = etohs (alevent);
+}
+
 /* ESC read process data ram function */
 static void ESC_read_pram (uint16_t address, void *buf, uint16_t len)
 {
    uint32_t value;
    uint8_t * temp_buf = buf;
    uint16_t byte_offset = 0;
-   uint8_t fifo_cnt, first_byte_position, temp_len;
-   uint8_t *buffer;
-   size_t i, array_size, size;
-   float quotient,remainder;
-   uint32_t temp;
+   uint8_t first_byte_position, temp_len;
+   size_t size;
    ssize_t n;
 
    value = ESC_PRAM_CMD_ABORT;
@@ -165,12 +317,8 @@ static void ESC_read_pram (uint16_t address, void *buf, uint16_t len)
       value = lan9252_read_32(ESC_PRAM_RD_CMD_REG);
    }while((value & ESC_PRAM_CMD_AVAIL) == 0);
 
-   /* Fifo count */
-   fifo_cnt = (uint8_t)ESC_PRAM_CMD_CNT(value);
-
    /* Read first value from FIFO */
    value = lan9252_read_32(ESC_PRAM_RD_FIFO_REG);
-   fifo_cnt--;
 
    /* Find out first byte position and adjust the copy from that
     * according to LAN9252 datasheet and MicroChip SDK code
@@ -182,42 +330,23 @@ static void ESC_read_pram (uint16_t address, void *buf, uint16_t len)
    len = (uint16_t)(len - temp_len);
    byte_offset = (uint16_t)(byte_offset + temp_len);
 
-   /* Continue reading until we have read len */
-    if (len > 0){
-
-        quotient = (float)(len/4);
-        remainder = (float)(len%4);
-        
-        if (remainder == 0)
-            array_size = (size_t)quotient;
-        else
-            array_size = (size_t)quotient+1;
-
-        size = 4*array_size;        
-
-        buffer = (uint8_t *)malloc(size);
-        buffer[0] = (uint8_t)size;
-        memset(buffer,0,size);    
-
-        lseek (lan9252, ESC_PRAM_RD_FIFO_REG, SEEK_SET);        
-        n = read (lan9252, buffer, size);
-        (void)n;
-                   
-        while(len > 0)
-        {
-        
-            for (i=0; i<size; i=i+4) {
-                temp_len = (len > 4) ? 4: (uint8_t)len;
-
-                temp = (uint32_t)(buffer[i] | (buffer[i+1] << 8) | (buffer[i+2] << 16) | (buffer[i+3] << 24));
-                memcpy(temp_buf + byte_offset ,&temp, temp_len);
-                fifo_cnt--;
-                len = (uint16_t)(len - temp_len);
-                byte_offset = (uint16_t)(byte_offset + temp_len);
-            }
-        }
-        free(buffer);
-    }
+   /* Continue reading until we have read len, in whole 32-bit words */
+   while (len > 0)
+   {
+      size = MIN ((size_t)(len + 3U) & ~(size_t)3U, ESC_PRAM_BUF_SIZE);
+
+      lseek (lan9252, ESC_PRAM_RD_FIFO_REG, SEEK_SET);
+      n = read (lan9252, pram_buf, size);
+      (void)n;
+
+      if (size > len)
+      {
+         size = len;
+      }
+      memcpy(temp_buf + byte_offset, pram_buf, size);
+      len = (uint16_t)(len - size);
+      byte_offset = (uint16_t)(byte_offset + size);
+   }
 }
 
 /* ESC write process data ram function */
@@ -226,10 +355,8 @@ static void ESC_write_pram (uint16_t address, void *buf, uint16_t len)
    uint32_t value;
    uint8_t * temp_buf = buf;
    uint16_t byte_offset = 0;
-   uint8_t fifo_cnt, first_byte_position, temp_len;
-   uint8_t *buffer;
-   size_t i, array_size, size;
-   float quotient,remainder;   
+   uint8_t first_byte_position, temp_len;
+   size_t size;
    ssize_t n;
 
    value = ESC_PRAM_CMD_ABORT;
@@ -251,9 +378,6 @@ static void ESC_write_pram (uint16_t address, void *buf, uint16_t len)
       value = lan9252_read_32(ESC_PRAM_WR_CMD_REG);
    }while((value & ESC_PRAM_CMD_AVAIL) == 0);
 
-   /* Fifo count */
-   fifo_cnt = (uint8_t)ESC_PRAM_CMD_CNT(value);
-
    /* Find out first byte position and adjust the copy from that
     * according to LAN9252 datasheet
     */
@@ -267,47 +391,28 @@ static void ESC_write_pram (uint16_t address, void *buf, uint16_t len)
 
    len = (uint16_t)(len - temp_len);
    byte_offset = (uint16_t)(byte_offset + temp_len);
-   fifo_cnt--;
-
-    if (len > 0){
-
-        quotient = len/4;
-        remainder = (float)(len%4);
-        
-        if (remainder == 0)
-            array_size = (size_t)quotient;
-        else
-            array_size = (size_t)quotient+1;
-
-        size = 3+4*array_size;        
-
-        buffer = (uint8_t *)malloc(size);
-        buffer[0] = (uint8_t)size;
-        memset(buffer,0,size);
-        
-        buffer[0] = ESC_CMD_SERIAL_WRITE;
-        buffer[1] = ((ESC_PRAM_WR_FIFO_REG >> 8) & 0xFF);
-        buffer[2] = (ESC_PRAM_WR_FIFO_REG & 0xFF); 
-        while(len > 0)
-        {                        
-            for (i=3; i<size; i=i+4) {           
-                temp_len = (len > 4) ? 4 : (uint8_t)len;
-
-                memcpy((uint8_t *)&value, (temp_buf + byte_offset), temp_len);
-                buffer[i] = (uint8_t)(value & 0xFF);
-                buffer[i+1] = (uint8_t)((value >> 8) & 0xFF);
-                buffer[i+2] = (uint8_t)((value >> 16) & 0xFF);
-                buffer[i+3] = (uint8_t)((value >> 24) & 0xFF);
-
-                fifo_cnt--;
-                len = (uint16_t)(len - temp_len);
-                byte_offset= (uint16_t)(byte_offset + temp_len);
-            }
-        }        
-        n = write (lan9252, buffer, size);
-        (void)n;
-        free(buffer);    
-    }
+
+   /* Continue writing until we have written len, in whole 32-bit words */
+   pram_buf[0] = ESC_CMD_SERIAL_WRITE;
+   pram_buf[1] = ((ESC_PRAM_WR_FIFO_REG >> 8) & 0xFF);
+   pram_buf[2] = (ESC_PRAM_WR_FIFO_REG & 0xFF);
+   while (len > 0)
+   {
+      size = MIN ((size_t)(len + 3U) & ~(size_t)3U,
+                  (ESC_PRAM_BUF_SIZE - ESC_PRAM_CMD_SIZE) & ~3U);
+
+      /* Zero the padding of the last word */
+      memset(&pram_buf[ESC_PRAM_CMD_SIZE + size - 4], 0, 4);
+      memcpy(&pram_buf[ESC_PRAM_CMD_SIZE], temp_buf + byte_offset,
+             MIN (size, len));
+
+      n = write (lan9252, pram_buf, ESC_PRAM_CMD_SIZE + size);
+      (void)n;
+
+      size = MIN (size, len);
+      len = (uint16_t)(len - size);
+      byte_offset = (uint16_t)(byte_offset + size);
+   }
 }
 
 
@@ -319,51 +424,34 @@ static void ESC_write_pram (uint16_t address, void *buf, uint16_t len)
  */
 void ESC_read (uint16_t address, void *buf, uint16_t len)
 {
+   pthread_mutex_lock (&esc_lock);
    /* Select Read function depending on address, process data ram or not */
    if (address >= 0x1000)
    {
       ESC_read_pram(address, buf, len);
+      ESC_flush_alevent ();
    }
    else
    {
-      uint16_t size;
-      uint8_t *temp_buf = (uint8_t *)buf;
+      ESC_queue_csr_access (address, buf, len, 0);
 
-      while(len > 0)
+      /* Reuse AlEvent if it was part of the read */
+      if ((address <= ESCREG_ALEVENT) &&
+          (address + len >= ESCREG_ALEVENT + sizeof(ESCvar.ALevent)))
       {
-         /* We write maximum 4 bytes at the time */
-         size = (len > 4) ? 4 : len;
-         /* Make size aligned to address according to LAN9252 datasheet
-          * Table 12-14 EtherCAT CSR Address VS size and MicroChip SDK code
-          */
-         /* If we got an odd address size is 1 , 01b 11b is captured */
-         if(address & BIT(0))
-         {
-            size = 1;
-         }
-         /* If address 1xb and size != 1 and 3 , allow size 2 else size 1 */
-         else if (address & BIT(1))
-         {
-            size = (size & BIT(0)) ? 1 : 2;
-         }
-         /* size 3 not valid */
-         else if (size == 3)
-         {
-            size = 1;
-         }
-         /* else size is kept AS IS */
-         ESC_read_csr(address, temp_buf, size);
+         uint16_t alevent;
 
-         /* next address */
-         len = (uint16_t)(len - size);
-         temp_buf = (uint8_t *)(temp_buf + size);
-         address = (uint16_t)(address + size);
+         ESC_flush_csr ();
+         memcpy (&alevent, (uint8_t *)buf + (ESCREG_ALEVENT - address),
+                 sizeof(alevent));
+         ESCvar.ALevent = etohs (alevent);
+      }
+      else
+      {
+         ESC_flush_alevent ();
       }
    }
-   /* To mimic the ET1100 always providing AlEvent on every read or write */
-   ESC_read_csr(ESCREG_ALEVENT,(void *)&ESCvar.ALevent,sizeof(ESCvar.ALevent));
-   ESCvar.ALevent = etohs (ESCvar.ALevent);
-
+   pthread_mutex_unlock (&esc_lock);
 }
 
 /** ESC write function used by the Slave stack.
@@ -374,6 +462,7 @@ void ESC_read (uint16_t address, void *buf, uint16_t len)
  */
 void ESC_write (uint16_t address, void *buf, uint16_t len)
 {
+   pthread_mutex_lock (&esc_lock);
    /* Select Write function depending on address, process data ram or not */
    if (address >= 0x1000)
    {
@@ -381,44 +470,10 @@ void ESC_write (uint16_t address, void *buf, uint16_t len)
    }
    else
    {
-      uint16_t size;
-      uint8_t *temp_buf = (uint8_t *)buf;
-
-      while(len > 0)
-      {
-         /* We write maximum 4 bytes at the time */
-         size = (len > 4) ? 4 : len;
-         /* Make size aligned to address according to LAN9252 datasheet
-          * Table 12-14 EtherCAT CSR Address VS size  and MicroChip SDK code
-          */
-         /* If we got an odd address size is 1 , 01b 11b is captured */
-         if(address & BIT(0))
-         {
-            size = 1;
-         }
-         /* If address 1xb and size != 1 and 3 , allow size 2 else size 1 */
-         else if (address & BIT(1))
-         {
-            size = (size & BIT(0)) ? 1 : 2;
-         }
-         /* size 3 not valid */
-         else if (size == 3)
-         {
-            size = 1;
-         }
-         /* else size is kept AS IS */
-         ESC_write_csr(address, temp_buf, size);
-
-         /* next address */
-         len = (uint16_t)(len - size);
-         temp_buf = (uint8_t *)(temp_buf + size);
-         address = (uint16_t)(address + size);
-      }
+      ESC_queue_csr_access (address, buf, len, 1);
    }
-
-   /* To mimic the ET1x00 always providing AlEvent on every read or write */
-   ESC_read_csr(ESCREG_ALEVENT,(void *)&ESCvar.ALevent,sizeof(ESCvar.ALevent));
-   ESCvar.ALevent = etohs (ESCvar.ALevent);
+   ESC_flush_alevent ();
+   pthread_mutex_unlock (&esc_lock);
 }
 
 /* Un-used due to evb-lan9252-digio not havning any possability to
@@ -431,10 +486,23 @@ void ESC_reset (void)
 
 void ESC_init (const esc_cfg_t * config)
 {
+   struct lan9252_csr_batch batch;
    uint32_t value;
    const char * spi_name = (char *)config->user_arg;
    lan9252 = open (spi_name, O_RDWR, 0);
 
+   /* Use CSR batches if the driver supports it, older drivers return 0
+    * for unknown ioctls. Probe by reading the station address.
+    */
+   csr_ops[0].address = ESCREG_ADDRESS;
+   csr_ops[0].len = 2;
+   csr_ops[0].write = 0;
+   csr_ops[0].data = 0;
+   batch.ops = (uint64_t)(uintptr_t)csr_ops;
+   batch.count = 1;
+   batch.reserved = 0;
+   csr_batch = (ioctl (lan9252, LAN9252_CSR_BATCH, &batch) == 1);
+
    /* Reset the ecat core here due to evb-lan9252-digio not having any GPIO
     * for that purpose.
     */
@@ -444,6 +512,47 @@ void ESC_init (const esc_cfg_t * config)
       value = lan9252_read_32(ESC_CSR_CMD_REG);
    } while(value & ESC_RESET_CTRL_RST);
 
+   /* Set AL event mask */
+   ESC_ALeventmaskwrite (ESCREG_ALEVENT_CONTROL |
+                         ESCREG_ALEVENT_SMCHANGE |
+                         ESCREG_ALEVENT_SM0 |
+                         ESCREG_ALEVENT_SM1);
+}
+
+void ESC_interrupt_enable (uint32_t mask)
+{
+   /* Enable interrupt for SYNC0 or SM2 or SM3 */
+   uint32_t user_int_mask = ESCREG_ALEVENT_DC_SYNC0 |
+                            ESCREG_ALEVENT_SM2 |
+                            ESCREG_ALEVENT_SM3;
+
+   if (mask & user_int_mask)
+   {
+      ESC_ALeventmaskwrite (ESC_ALeventmaskread () | (mask & user_int_mask));
+   }
 
+   pthread_mutex_lock (&esc_lock);
+   /* Set LAN9252 interrupt pin driver as push-pull active high */
+   lan9252_write_32 (ESC_IRQ_CFG_REG, ESC_IRQ_CFG_EN | ESC_IRQ_CFG_POL_HIGH |
+                     ESC_IRQ_CFG_PUSH_PULL);
+   /* Enable LAN9252 interrupt */
+   lan9252_write_32 (ESC_INT_EN_REG, ESC_INT_EN_ECAT);
+   pthread_mutex_unlock (&esc_lock);
+}
+
+void ESC_interrupt_disable (uint32_t mask)
+{
+   uint32_t user_int_mask = ESCREG_ALEVENT_DC_SYNC0 |
+                            ESCREG_ALEVENT_SM2 |
+                            ESCREG_ALEVENT_SM3;
+
+   if (mask & user_int_mask)
+   {
+      ESC_ALeventmaskwrite (ESC_ALeventmaskread () & ~(mask & user_int_mask));
+   }
 
+   /* Disable LAN9252 interrupt */
+   pthread_mutex_lock (&esc_lock);
+   lan9252_write_32 (ESC_INT_EN_REG, 0);
+   pthread_mutex_unlock (&esc_lock);
 }
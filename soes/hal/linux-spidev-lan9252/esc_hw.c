@@ -0,0 +1,774 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * ESC hardware layer functions for LAN9252 through Linux spidev.
+ *
+ * Function to read and write commands to the ESC. Used to read/write ESC
+ * registers and memory. SPI commands are chained into one SPI_IOC_MESSAGE
+ * per ESC access, with chip select toggled between commands. Polls of busy
+ * and FIFO status are sent optimistically in the same message and the
+ * access is redone if the poll shows the LAN9252 was not ready. Accesses
+ * that can't be redone, CSR writes and Sync Manager buffer transfers, are
+ * not sent behind an unconfirmed poll.
+ *
+ * Accesses are serialized, the stack may run from several threads when
+ * interrupt driven.
+ */
+#include "esc.h"
+#include "esc_hw.h"
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+#define BIT(x)                   (1U << (x))
+
+#define ESC_CMD_SERIAL_WRITE     0x02
+#define ESC_CMD_SERIAL_READ      0x03
+
+#define ESC_CMD_RESET_CTL        0x01F8      // reset register
+#define ESC_CMD_HW_CFG           0x0074      // hardware configuration register
+#define ESC_CMD_BYTE_TEST        0x0064      // byte order test register
+#define ESC_CMD_ID_REV           0x0050      // chip ID and revision
+#define ESC_CMD_IRQ_CFG          0x0054      // interrupt configuration
+#define ESC_CMD_INT_EN           0x005C      // interrupt enable
+
+#define ESC_RESET_ETHERCAT       0x00000040
+#define ESC_HW_CFG_READY         0x08000000
+#define ESC_BYTE_TEST_OK         0x87654321
+
+#define ESC_PRAM_RD_FIFO_REG     0x0000
+#define ESC_PRAM_WR_FIFO_REG     0x0020
+#define ESC_PRAM_RD_ADDR_LEN_REG 0x0308
+#define ESC_PRAM_RD_CMD_REG      0x030C
+#define ESC_PRAM_WR_ADDR_LEN_REG 0x0310
+#define ESC_PRAM_WR_CMD_REG      0x0314
+
+#define ESC_PRAM_CMD_BUSY        0x80000000
+#define ESC_PRAM_CMD_ABORT       0x40000000
+#define ESC_PRAM_CMD_AVAIL       0x00000001
+#define ESC_PRAM_CMD_CNT(x)      (((x) >> 8) & 0x1F)
+#define ESC_PRAM_SIZE(x)         ((x) << 16)
+#define ESC_PRAM_ADDR(x)         ((x) << 0)
+#define ESC_PRAM_FIFO_WORDS      16
+
+#define ESC_CSR_DATA_REG         0x0300
+#define ESC_CSR_CMD_REG          0x0304
+
+#define ESC_CSR_CMD_BUSY         0x80000000
+#define ESC_CSR_CMD_READ         (0x80000000 | 0x40000000)
+#define ESC_CSR_CMD_WRITE        0x80000000
+#define ESC_CSR_CMD_SIZE(x)      ((x) << 16)
+
+/* Size of a 32-bit register command, 1 byte command, 2 bytes address and
+ * 4 bytes data
+ */
+#define ESC_SPI_CMD_SIZE         7
+#define ESC_SPI_HDR_SIZE         3
+
+#ifndef ESC_SPI_SPEED_HZ
+#define ESC_SPI_SPEED_HZ         10000000
+#endif
+
+/* Max number of commands and bytes in one SPI message */
+#define ESC_SPI_XFER_MAX         64
+#define ESC_SPI_BUF_SIZE         1024
+
+/* Max number of CSR accesses in one SPI message */
+#define ESC_CSR_OP_MAX           16
+
+/* Number of optimistic attempts before polling in separate messages */
+#define ESC_SPI_RETRIES          3
+
+typedef struct
+{
+   uint16_t address;
+   uint16_t len;
+   uint8_t write;
+   uint8_t * buf;
+   uint8_t * poll;
+   uint8_t * data;
+} esc_csr_op_t;
+
+static int spidev = -1;
+static pthread_mutex_t esc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct spi_ioc_transfer xfer[ESC_SPI_XFER_MAX];
+static uint8_t xfer_buf[ESC_SPI_BUF_SIZE];
+static unsigned int xfer_count;
+static size_t xfer_used;
+
+static esc_csr_op_t csr_ops[ESC_CSR_OP_MAX];
+static unsigned int csr_count;
+
+static int spi_fits (unsigned int count, size_t size)
+{
+   return ((xfer_count + count) <= ESC_SPI_XFER_MAX) &&
+          ((xfer_used + size) <= ESC_SPI_BUF_SIZE);
+}
+
+/* Add one SPI command to the message, returns its tx/rx buffer */
+static uint8_t * spi_queue (size_t len)
+{
+   struct spi_ioc_transfer * t = &xfer[xfer_count++];
+   uint8_t * p = &xfer_buf[xfer_used];
+
+   xfer_used += len;
+   memset (t, 0, sizeof (*t));
+   t->tx_buf = (uint64_t)(uintptr_t)p;
+   t->rx_buf = (uint64_t)(uintptr_t)p;
+   t->len = (uint32_t)len;
+   t->speed_hz = ESC_SPI_SPEED_HZ;
+   t->bits_per_word = 8;
+   /* Release chip select between commands */
+   t->cs_change = 1;
+
+   return p;
+}
+
+/* Send all queued SPI commands in one ioctl */
+static void spi_flush (void)
+{
+   int n;
+
+   if (xfer_count > 0)
+   {
+      /* Release chip select at the end of the message */
+      xfer[xfer_count - 1].cs_change = 0;
+      n = ioctl (spidev, SPI_IOC_MESSAGE (xfer_count), xfer);
+      if (n < 0)
+      {
+         DPRINT ("SPI_IOC_MESSAGE failed\n");
+      }
+   }
+   xfer_count = 0;
+   xfer_used = 0;
+}
+
+static void spi_queue_write_32 (uint16_t address, uint32_t val)
+{
+   uint8_t * data = spi_queue (ESC_SPI_CMD_SIZE);
+
+   data[0] = ESC_CMD_SERIAL_WRITE;
+   data[1] = (uint8_t)((address >> 8) & 0xFF);
+   data[2] = (uint8_t)(address & 0xFF);
+   data[3] = (uint8_t)(val & 0xFF);
+   data[4] = (uint8_t)((val >> 8) & 0xFF);
+   data[5] = (uint8_t)((val >> 16) & 0xFF);
+   data[6] = (uint8_t)((val >> 24) & 0xFF);
+}
+
+/* Queue a read, the data is available at the returned buffer after flush */
+static uint8_t * spi_queue_read (uint16_t address, size_t len)
+{
+   uint8_t * data = spi_queue (ESC_SPI_HDR_SIZE + len);
+
+   data[0] = ESC_CMD_SERIAL_READ;
+   data[1] = (uint8_t)((address >> 8) & 0xFF);
+   data[2] = (uint8_t)(address & 0xFF);
+   memset (&data[ESC_SPI_HDR_SIZE], 0, len);
+
+   return &data[ESC_SPI_HDR_SIZE];
+}
+
+static uint32_t spi_value_32 (const uint8_t * data)
+{
+   return (uint32_t)data[0] |
+          ((uint32_t)data[1] << 8) |
+          ((uint32_t)data[2] << 16) |
+          ((uint32_t)data[3] << 24);
+}
+
+/* spidev single write */
+static void spidev_write_32 (uint16_t address, uint32_t val)
+{
+   spi_queue_write_32 (address, val);
+   spi_flush ();
+}
+
+/* spidev single read */
+static uint32_t spidev_read_32 (uint16_t address)
+{
+   uint8_t * data = spi_queue_read (address, 4);
+
+   spi_flush ();
+   return spi_value_32 (data);
+}
+
+/* Queue the SPI commands of one CSR access, command, busy poll and data */
+static void ESC_queue_csr_cmds (esc_csr_op_t * op)
+{
+   uint32_t value;
+
+   if (op->write)
+   {
+      value = 0;
+      memcpy (&value, op->buf, op->len);
+      spi_queue_write_32 (ESC_CSR_DATA_REG, value);
+      value = ESC_CSR_CMD_WRITE;
+   }
+   else
+   {
+      value = ESC_CSR_CMD_READ;
+   }
+   value |= (uint32_t)ESC_CSR_CMD_SIZE (op->len) | op->address;
+   spi_queue_write_32 (ESC_CSR_CMD_REG, value);
+   op->poll = spi_queue_read (ESC_CSR_CMD_REG, 4);
+   op->data = (op->write) ? NULL : spi_queue_read (ESC_CSR_DATA_REG, 4);
+}
+
+/* Check the outcome of the CSR accesses sent in the last message. An access
+ * still busy when polled is waited for, then the accesses following it,
+ * that were issued while busy, are sent again. A busy read is sent again
+ * as well, its data may have been replaced by a following read. Writes
+ * are only queued first in a message, a busy write completes with its own
+ * data and following accesses are reads.
+ */
+static void ESC_complete_csr (void)
+{
+   unsigned int i = 0;
+   unsigned int j;
+   uint32_t value;
+
+   while (i < csr_count)
+   {
+      esc_csr_op_t * op = &csr_ops[i];
+
+      value = spi_value_32 (op->poll);
+      if (value & ESC_CSR_CMD_BUSY)
+      {
+         do
+         {
+            value = spidev_read_32 (ESC_CSR_CMD_REG);
+         } while (value & ESC_CSR_CMD_BUSY);
+
+         /* Redo the remaining accesses, the busy one first if a read */
+         if (op->write)
+         {
+            i++;
+         }
+         for (j = i; j < csr_count; j++)
+         {
+            csr_ops[j - i] = csr_ops[j];
+            ESC_queue_csr_cmds (&csr_ops[j - i]);
+         }
+         csr_count = csr_count - i;
+         spi_flush ();
+         i = 0;
+         continue;
+      }
+
+      if (!op->write)
+      {
+         value = spi_value_32 (op->data);
+         memcpy (op->buf, &value, op->len);
+      }
+      i++;
+   }
+   csr_count = 0;
+}
+
+/* Send queued commands and complete the CSR accesses among them */
+static void ESC_flush (void)
+{
+   spi_flush ();
+   ESC_complete_csr ();
+}
+
+/* Queue one CSR access, read data is copied to buf when completed. A
+ * write is sent in a new message, if queued behind an access not yet
+ * confirmed it could overwrite the data of that access.
+ */
+static void ESC_queue_csr (uint16_t address, void *buf, uint16_t len,
+                           uint8_t write)
+{
+   esc_csr_op_t * op;
+
+   if ((write && (csr_count > 0)) ||
+       (csr_count == ESC_CSR_OP_MAX) ||
+       !spi_fits (4, 4 * (ESC_SPI_CMD_SIZE + 1)))
+   {
+      ESC_flush ();
+   }
+
+   op = &csr_ops[csr_count++];
+   op->address = address;
+   op->len = len;
+   op->write = write;
+   op->buf = buf;
+   ESC_queue_csr_cmds (op);
+}
+
+/* Split a CSR access in valid sizes and queue them */
+static void ESC_queue_csr_access (uint16_t address, void *buf, uint16_t len,
+                                  uint8_t write)
+{
+   uint16_t size;
+   uint8_t *temp_buf = (uint8_t *)buf;
+
+   while(len > 0)
+   {
+      /* We write maximum 4 bytes at the time */
+      size = (len > 4) ? 4 : len;
+      /* Make size aligned to address according to LAN9252 datasheet
+       * Table 12-14 EtherCAT CSR Address VS size and MicroChip SDK code
+       */
+      /* If we got an odd address size is 1 , 01b 11b is captured */
+      if(address & BIT(0))
+      {
+         size = 1;
+      }
+      /* If address 1xb and size != 1 and 3 , allow size 2 else size 1 */
+      else if (address & BIT(1))
+      {
+         size = (size & BIT(0)) ? 1 : 2;
+      }
+      /* size 3 not valid */
+      else if (size == 3)
+      {
+         size = 1;
+      }
+      /* else size is kept AS IS */
+      ESC_queue_csr (address, temp_buf, size, write);
+
+      /* next address */
+      len = (uint16_t)(len - size);
+      temp_buf = (uint8_t *)(temp_buf + size);
+      address = (uint16_t)(address + size);
+   }
+}
+
+/* Start a PRAM FIFO transfer, abort any ongoing one and program address
+ * and length. When optimistic, the abort is not waited for and the
+ * returned poll must show it completed once the message has been sent.
+ */
+static uint8_t * ESC_start_pram (uint16_t cmd_reg, uint16_t addr_len_reg,
+                                 uint16_t address, uint16_t len,
+                                 int optimistic)
+{
+   uint8_t * poll = NULL;
+
+   spi_queue_write_32 (cmd_reg, ESC_PRAM_CMD_ABORT);
+   if (optimistic)
+   {
+      poll = spi_queue_read (cmd_reg, 4);
+   }
+   else
+   {
+      spi_flush ();
+      while (spidev_read_32 (cmd_reg) & ESC_PRAM_CMD_BUSY)
+      {
+      }
+   }
+
+   spi_queue_write_32 (addr_len_reg,
+                       (uint32_t)(ESC_PRAM_SIZE (len) | ESC_PRAM_ADDR (address)));
+   spi_queue_write_32 (cmd_reg, ESC_PRAM_CMD_BUSY);
+
+   return poll;
+}
+
+/* Check polls sent with a PRAM FIFO transfer, returns 0 if the LAN9252
+ * was not ready and the transfer must be redone.
+ */
+static int ESC_check_pram (uint8_t ** abort_poll, uint8_t * poll,
+                           uint8_t words)
+{
+   uint32_t value;
+
+   if (*abort_poll != NULL)
+   {
+      value = spi_value_32 (*abort_poll);
+      *abort_poll = NULL;
+      if (value & ESC_PRAM_CMD_BUSY)
+      {
+         return 0;
+      }
+   }
+
+   if (poll != NULL)
+   {
+      value = spi_value_32 (poll);
+      if (!(value & ESC_PRAM_CMD_AVAIL) || (ESC_PRAM_CMD_CNT (value) < words))
+      {
+         return 0;
+      }
+   }
+
+   return 1;
+}
+
+/* Wait until the PRAM FIFO holds, or has room for, words 32-bit words */
+static void ESC_wait_pram (uint16_t cmd_reg, uint8_t words)
+{
+   uint32_t value;
+
+   do
+   {
+      value = spidev_read_32 (cmd_reg);
+   } while (!(value & ESC_PRAM_CMD_AVAIL) || (ESC_PRAM_CMD_CNT (value) < words));
+}
+
+static int ESC_sm_overlap (uint32_t start, uint32_t end, uint16_t sma,
+                           uint16_t sml)
+{
+   return (start < ((uint32_t)sma + sml)) && (end > sma);
+}
+
+/* Check if a process data ram access touches a Sync Manager buffer. The
+ * LAN9252 prefetches reads and the access to the last byte of a buffer
+ * releases it, a transfer to it can't be aborted and redone.
+ */
+static int ESC_sm_buffer (uint16_t address, uint16_t len)
+{
+   uint32_t end = (uint32_t)address + len;
+
+   if ((ESCvar.activemb0 != NULL) &&
+       ESC_sm_overlap (address, end, ESC_MBX0_sma, ESC_MBX0_sml))
+   {
+      return 1;
+   }
+   if ((ESCvar.activemb1 != NULL) &&
+       ESC_sm_overlap (address, end, ESC_MBX1_sma, ESC_MBX1_sml))
+   {
+      return 1;
+   }
+   return ESC_sm_overlap (address, end, ESC_SM2_sma, ESCvar.ESC_SM2_sml) ||
+          ESC_sm_overlap (address, end, ESC_SM3_sma, ESCvar.ESC_SM3_sml);
+}
+
+/* ESC read process data ram function. Sync Manager buffers wait for the
+ * FIFO before every read, other areas are read optimistically.
+ */
+static void ESC_read_pram (uint16_t address, void *buf, uint16_t len)
+{
+   uint8_t * temp_buf = buf;
+   uint8_t first_byte_position = (address & 0x03);
+   int attempt = ESC_sm_buffer (address, len) ? ESC_SPI_RETRIES : 0;
+
+   for (; attempt <= ESC_SPI_RETRIES; attempt++)
+   {
+      uint16_t words = (uint16_t)((first_byte_position + len + 3) / 4);
+      uint16_t remaining = len;
+      uint16_t byte_offset = 0;
+      uint16_t skip = first_byte_position;
+      int optimistic = (attempt < ESC_SPI_RETRIES);
+      uint8_t * abort_poll;
+
+      abort_poll = ESC_start_pram (ESC_PRAM_RD_CMD_REG,
+                                   ESC_PRAM_RD_ADDR_LEN_REG,
+                                   address, len, optimistic);
+
+      while (words > 0)
+      {
+         uint8_t fifo_range = (uint8_t)MIN (words, ESC_PRAM_FIFO_WORDS);
+         uint16_t size = (uint16_t)(fifo_range * 4 - skip);
+         uint8_t * poll = NULL;
+         uint8_t * data;
+
+         if (size > remaining)
+         {
+            size = remaining;
+         }
+
+         /* Poll and read the FIFO in the same message, or wait for the
+          * FIFO first when optimistic attempts have failed
+          */
+         if (optimistic)
+         {
+            poll = spi_queue_read (ESC_PRAM_RD_CMD_REG, 4);
+         }
+         else
+         {
+            spi_flush ();
+            ESC_wait_pram (ESC_PRAM_RD_CMD_REG, fifo_range);
+         }
+         data = spi_queue_read (ESC_PRAM_RD_FIFO_REG, (size_t)fifo_range * 4);
+         spi_flush ();
+
+         if (!ESC_check_pram (&abort_poll, poll, fifo_range))
+         {
+            break;
+         }
+
+         memcpy (temp_buf + byte_offset, data + skip, size);
+         byte_offset = (uint16_t)(byte_offset + size);
+         remaining = (uint16_t)(remaining - size);
+         words = (uint16_t)(words - fifo_range);
+         skip = 0;
+      }
+
+      if (words == 0)
+      {
+         return;
+      }
+   }
+}
+
+/* ESC write process data ram function. Sync Manager buffers wait for
+ * FIFO space before every write, other areas are written optimistically.
+ */
+static void ESC_write_pram (uint16_t address, void *buf, uint16_t len)
+{
+   const uint8_t * temp_buf = buf;
+   uint8_t first_byte_position = (address & 0x03);
+   int attempt = ESC_sm_buffer (address, len) ? ESC_SPI_RETRIES : 0;
+
+   for (; attempt <= ESC_SPI_RETRIES; attempt++)
+   {
+      uint16_t words = (uint16_t)((first_byte_position + len + 3) / 4);
+      uint16_t remaining = len;
+      uint16_t byte_offset = 0;
+      uint16_t skip = first_byte_position;
+      int optimistic = (attempt < ESC_SPI_RETRIES);
+      uint8_t * abort_poll;
+
+      abort_poll = ESC_start_pram (ESC_PRAM_WR_CMD_REG,
+                                   ESC_PRAM_WR_ADDR_LEN_REG,
+                                   address, len, optimistic);
+
+      while (words > 0)
+      {
+         uint8_t fifo_range = (uint8_t)MIN (words, ESC_PRAM_FIFO_WORDS);
+         uint16_t size = (uint16_t)(fifo_range * 4 - skip);
+         uint8_t * poll = NULL;
+         uint8_t * data;
+
+         if (size > remaining)
+         {
+            size = remaining;
+         }
+
+         /* Poll for FIFO space in the same message as the write, the
+          * poll is sent first and validates the write following it
+          */
+         if (optimistic)
+         {
+            poll = spi_queue_read (ESC_PRAM_WR_CMD_REG, 4);
+         }
+         else
+         {
+            spi_flush ();
+            ESC_wait_pram (ESC_PRAM_WR_CMD_REG, fifo_range);
+         }
+         data = spi_queue (ESC_SPI_HDR_SIZE + (size_t)fifo_range * 4);
+         data[0] = ESC_CMD_SERIAL_WRITE;
+         data[1] = (uint8_t)((ESC_PRAM_WR_FIFO_REG >> 8) & 0xFF);
+         data[2] = (uint8_t)(ESC_PRAM_WR_FIFO_REG & 0xFF);
+         memset (&data[ESC_SPI_HDR_SIZE], 0, (size_t)fifo_range * 4);
+         memcpy (&data[ESC_SPI_HDR_SIZE + skip], temp_buf + byte_offset, size);
+         spi_flush ();
+
+         if (!ESC_check_pram (&abort_poll, poll, fifo_range))
+         {
+            break;
+         }
+
+         byte_offset = (uint16_t)(byte_offset + size);
+         remaining = (uint16_t)(remaining - size);
+         words = (uint16_t)(words - fifo_range);
+         skip = 0;
+      }
+
+      if (words == 0)
+      {
+         return;
+      }
+   }
+}
+
+/* Queue the AlEvent read done after every access, to mimic the ET1x00
+ * always providing AlEvent on every read or write, and send the message.
+ */
+static void ESC_flush_alevent (void)
+{
+   uint16_t alevent;
+
+   ESC_queue_csr (ESCREG_ALEVENT, &alevent, sizeof(alevent), 0);
+   ESC_flush ();
+   ESCvar.ALevent = etohs (alevent);
+}
+
+/** ESC read function used by the Slave stack.
+ *
+ * @param[in]   address     = address of ESC register to read
+ * @param[out]  buf         = pointer to buffer to read in
+ * @param[in]   len         = number of bytes to read
+ */
+void ESC_read (uint16_t address, void *buf, uint16_t len)
+{
+   pthread_mutex_lock (&esc_lock);
+   /* Select Read function depending on address, process data ram or not */
+   if (address >= 0x1000)
+   {
+      ESC_read_pram(address, buf, len);
+      ESC_flush_alevent ();
+   }
+   else
+   {
+      ESC_queue_csr_access (address, buf, len, 0);
+
+      /* Reuse AlEvent if it was part of the read */
+      if ((address <= ESCREG_ALEVENT) &&
+          (address + len >= ESCREG_ALEVENT + sizeof(ESCvar.ALevent)))
+      {
+         uint16_t alevent;
+
+         ESC_flush ();
+         memcpy (&alevent, (uint8_t *)buf + (ESCREG_ALEVENT - address),
+                 sizeof(alevent));
+         ESCvar.ALevent = etohs (alevent);
+      }
+      else
+      {
+         ESC_flush_alevent ();
+      }
+   }
+   pthread_mutex_unlock (&esc_lock);
+}
+
+/** ESC write function used by the Slave stack.
+ *
+ * @param[in]   address     = address of ESC register to write
+ * @param[out]  buf         = pointer to buffer to write from
+ * @param[in]   len         = number of bytes to write
+ */
+void ESC_write (uint16_t address, void *buf, uint16_t len)
+{
+   pthread_mutex_lock (&esc_lock);
+   /* Select Write function depending on address, process data ram or not */
+   if (address >= 0x1000)
+   {
+      ESC_write_pram(address, buf, len);
+   }
+   else
+   {
+      ESC_queue_csr_access (address, buf, len, 1);
+   }
+   ESC_flush_alevent ();
+   pthread_mutex_unlock (&esc_lock);
+}
+
+/* Un-used due to evb-lan9252-digio not havning any possability to
+ * reset except over SPI.
+ */
+void ESC_reset (void)
+{
+
+}
+
+void ESC_init (const esc_cfg_t * config)
+{
+   uint8_t mode = SPI_MODE_0;
+   uint8_t bits = 8;
+   uint32_t speed = ESC_SPI_SPEED_HZ;
+   uint32_t value;
+   uint32_t counter = 0;
+   uint32_t timeout = 1000; // wait 100msec
+   const char * spi_name = (char *)config->user_arg;
+
+   spidev = open (spi_name, O_RDWR, 0);
+   if (spidev < 0)
+   {
+      DPRINT ("Failed to open %s\n", spi_name);
+      return;
+   }
+
+   if ((ioctl (spidev, SPI_IOC_WR_MODE, &mode) < 0) ||
+       (ioctl (spidev, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0) ||
+       (ioctl (spidev, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0))
+   {
+      DPRINT ("Failed to configure %s\n", spi_name);
+      return;
+   }
+
+   // Reset the ecat core here due to evb-lan9252-digio not having any GPIO for that purpose.
+   spidev_write_32 (ESC_CMD_RESET_CTL, ESC_RESET_ETHERCAT);
+
+   // Wait until reset command has been executed
+   do
+   {
+      usleep (100);
+      counter++;
+      value = spidev_read_32 (ESC_CMD_RESET_CTL);
+   } while ((value & ESC_RESET_ETHERCAT) && (counter < timeout));
+
+   // Perform byte test
+   do
+   {
+      usleep (100);
+      counter++;
+      value = spidev_read_32 (ESC_CMD_BYTE_TEST);
+   } while ((value != ESC_BYTE_TEST_OK) && (counter < timeout));
+
+   // Check hardware is ready
+   do
+   {
+      usleep (100);
+      counter++;
+      value = spidev_read_32 (ESC_CMD_HW_CFG);
+   } while (!(value & ESC_HW_CFG_READY) && (counter < timeout));
+
+   // Check if timeout occured
+   if (counter < timeout)
+   {
+      // Read the chip identification and revision
+      value = spidev_read_32 (ESC_CMD_ID_REV);
+      DPRINT ("Detected chip %x Rev %u \n", ((value >> 16) & 0xFFFF), (value & 0xFFFF));
+
+      // Set AL event mask
+      value = (ESCREG_ALEVENT_CONTROL |
+               ESCREG_ALEVENT_SMCHANGE |
+               ESCREG_ALEVENT_SM0 |
+               ESCREG_ALEVENT_SM1 );
+      ESC_ALeventmaskwrite (value);
+   }
+   else
+   {
+      DPRINT ("Timeout occurred during reset \n");
+   }
+}
+
+void ESC_interrupt_enable (uint32_t mask)
+{
+   // Enable interrupt for SYNC0 or SM2 or SM3
+   uint32_t user_int_mask = ESCREG_ALEVENT_DC_SYNC0 |
+                            ESCREG_ALEVENT_SM2 |
+                            ESCREG_ALEVENT_SM3;
+   if (mask & user_int_mask)
+   {
+      ESC_ALeventmaskwrite (ESC_ALeventmaskread () | (mask & user_int_mask));
+   }
+
+   pthread_mutex_lock (&esc_lock);
+   // Set LAN9252 interrupt pin driver as push-pull active high
+   spidev_write_32 (ESC_CMD_IRQ_CFG, 0x00000111);
+
+   // Enable LAN9252 interrupt
+   spidev_write_32 (ESC_CMD_INT_EN, 0x00000001);
+   pthread_mutex_unlock (&esc_lock);
+}
+
+void ESC_interrupt_disable (uint32_t mask)
+{
+   uint32_t user_int_mask = ESCREG_ALEVENT_DC_SYNC0 |
+                            ESCREG_ALEVENT_SM2 |
+                            ESCREG_ALEVENT_SM3;
+
+   if (mask & user_int_mask)
+   {
+      ESC_ALeventmaskwrite (ESC_ALeventmaskread () & ~(mask & user_int_mask));
+   }
+
+   // Disable LAN9252 interrupt
+   pthread_mutex_lock (&esc_lock);
+   spidev_write_32 (ESC_CMD_INT_EN, 0x00000000);
+   pthread_mutex_unlock (&esc_lock);
+}
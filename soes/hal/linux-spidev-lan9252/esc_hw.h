@@ -0,0 +1,17 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+ /** \file
+ * \brief
+ * ESC hardware specific interrupt functions.
+ */
+
+#ifndef __esc_hw__
+#define __esc_hw__
+
+void ESC_interrupt_enable (uint32_t mask);
+void ESC_interrupt_disable (uint32_t mask);
+
+#endif
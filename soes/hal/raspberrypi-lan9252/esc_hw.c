@@ -49,6 +49,7 @@
 #define ESC_PRAM_CMD_CNT(x)      (((x) >> 8) & 0x1F)
 #define ESC_PRAM_SIZE(x)         ((x) << 16)
 #define ESC_PRAM_ADDR(x)         ((x) << 0)
+#define ESC_PRAM_FIFO_MAX        0x1F
 
 #define ESC_CSR_DATA_REG         0x0300
 #define ESC_CSR_CMD_REG          0x0304
@@ -58,6 +59,9 @@
 #define ESC_CSR_CMD_WRITE        0x80000000
 #define ESC_CSR_CMD_SIZE(x)      ((x) << 16)
 
+/* Preallocated PRAM FIFO transfer buffer, command header and a full FIFO */
+static uint8_t pram_buf[3 + 4 * ESC_PRAM_FIFO_MAX] __attribute__((aligned (64)));
+
 /* bcm2835 spi single write */
 static void bcm2835_spi_write_32 (uint16_t address, uint32_t val)
 {
@@ -133,7 +137,7 @@ static void ESC_read_pram (uint16_t address, void *buf, uint16_t len)
    uint8_t * temp_buf = buf;
    uint16_t quotient, remainder, byte_offset = 0;
    uint8_t fifo_cnt, fifo_size, fifo_range, first_byte_position, temp_len;
-   uint8_t *buffer = NULL;
+   uint8_t *buffer = pram_buf;
    int i, size;
 
    bcm2835_spi_write_32(ESC_PRAM_RD_CMD_REG, ESC_PRAM_CMD_ABORT);
@@ -181,9 +185,6 @@ static void ESC_read_pram (uint16_t address, void *buf, uint16_t len)
       /* Transfer data size */
       size = 3+4*fifo_size;
 
-      /* Allocate buffer */
-      buffer = (uint8_t *)realloc(buffer, size);
-
       /* Reset fifo count */
       fifo_cnt = fifo_size;
 
@@ -218,7 +219,6 @@ static void ESC_read_pram (uint16_t address, void *buf, uint16_t len)
          byte_offset += temp_len;
       }
    }
-   free(buffer);
 }
 
 /* ESC write process data ram function */
@@ -228,7 +228,7 @@ static void ESC_write_pram (uint16_t address, void *buf, uint16_t len)
    uint8_t * temp_buf = buf;
    uint16_t quotient, remainder, byte_offset = 0;
    uint8_t fifo_cnt, fifo_size, fifo_range, first_byte_position, temp_len;
-   uint8_t *buffer = NULL;
+   uint8_t *buffer = pram_buf;
    int i, size;
 
    bcm2835_spi_write_32(ESC_PRAM_WR_CMD_REG, ESC_PRAM_CMD_ABORT);
@@ -276,9 +276,6 @@ static void ESC_write_pram (uint16_t address, void *buf, uint16_t len)
       /* Transfer data size */
       size = 3+4*fifo_size;
 
-      /* Allocate buffer */
-      buffer = (uint8_t *)realloc(buffer, size);
-
       /* Reset fifo count */
       fifo_cnt = fifo_size;
 
@@ -317,7 +314,6 @@ static void ESC_write_pram (uint16_t address, void *buf, uint16_t len)
       /* Transfer batch of data */
       bcm2835_spi_transfern((char *)buffer, size);
    }
-   free(buffer);
 }
 
 /** ESC read function used by the Slave stack.
@@ -18,6 +18,7 @@
 #include "esc_hw.h"
 #include "esc_eep.h"
 #include "ecat_slv.h"
+#include "esc_stats.h"
 #include "esc_hw_eep.h"
 
 #define ESCADDR(x)   (((uint8_t *) ECAT0_BASE) + x)
@@ -213,6 +214,8 @@ void ESC_eep_handler(void)
  */
 static void sync0_isr (void * arg)
 {
+   ESC_STATS_SYNC0();
+
    /* Subtract the sync counter to check the pace compared to the SM IRQ */
    if((CC_ATOMIC_GET(ESCvar.App.state) & APPSTATE_OUTPUT) > 0)
    {
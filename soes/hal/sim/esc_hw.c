@@ -0,0 +1,583 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+ /** \file
+ * \brief
+ * ESC hardware layer functions for an in-memory ESC simulator.
+ *
+ * The ESC register and process data RAM image is kept in host memory. Accesses
+ * from the slave stack (PDI side) and from the master (EtherCAT side, see
+ * esc_hw.h) pass through the same SyncManager logic, giving mailbox full/empty
+ * and 3-buffer semantics together with AL event generation. Used to run the
+ * stack on a host without any ESC, e.g. for benchmarking.
+ *
+ * The IRQ output is emulated with an eventfd, signalled when an AL event
+ * enabled in the AL event mask becomes pending.
+ */
+#include "esc.h"
+#include "esc_hw.h"
+#include <string.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define SIM_SM_COUNT             8
+#define SIM_SMREG(n)             ((uint16_t)(ESCREG_SM0 + ((n) << 3)))
+#define SIM_PRAM_START           0x1000
+
+#define SIM_SM_MODE_MASK         0x03
+#define SIM_SM_MODE_MBX          0x02
+#define SIM_SM_DIR_MASK          0x0C
+#define SIM_SM_DIR_ECAT_WRITE    0x04
+
+#define SIM_SM_STAT_INTW         0x01
+#define SIM_SM_STAT_INTR         0x02
+#define SIM_SM_STAT_MBXFULL      0x08
+#define SIM_SM_STAT_BUF_MASK     0x30
+#define SIM_SM_STAT_BUF(x)       ((uint8_t)((x) << 4))
+#define SIM_SM_BUF_NONE          3
+
+#define SIM_DLSTATUS_PDI_OP      0x0001
+
+/* Runtime state of a SyncManager, buffer indexes are -1 when not in use */
+typedef struct
+{
+   int8_t latest;    /* last completely written buffer */
+   int8_t wbuf;      /* buffer opened by the writing side */
+   int8_t rbuf;      /* buffer opened by the reading side */
+} sim_sm_t;
+
+static uint8_t esc_mem[ESC_SIM_MEMSIZE];
+static sim_sm_t sim_sm[SIM_SM_COUNT];
+/* AL event bits not derived from SyncManager status */
+static uint32_t sim_event;
+/* Serialize the master and PDI side accesses */
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static int sim_irq_fd = -1;
+static int sim_irq;
+
+static uint16_t sim_get16 (uint32_t address)
+{
+   return (uint16_t)(esc_mem[address] | (esc_mem[address + 1] << 8));
+}
+
+static void sim_set16 (uint32_t address, uint16_t value)
+{
+   esc_mem[address] = (uint8_t)(value & 0xFF);
+   esc_mem[address + 1] = (uint8_t)(value >> 8);
+}
+
+static uint32_t sim_alevent (void)
+{
+   return (uint32_t)(esc_mem[ESCREG_ALEVENT] |
+         (esc_mem[ESCREG_ALEVENT + 1] << 8) |
+         (esc_mem[ESCREG_ALEVENT + 2] << 16) |
+         ((uint32_t)esc_mem[ESCREG_ALEVENT + 3] << 24));
+}
+
+static int sim_sm_enabled (uint8_t n)
+{
+   uint16_t reg = SIM_SMREG (n);
+
+   return ((esc_mem[reg + 6] & ESCREG_SMENABLE_BIT) != 0) &&
+      ((esc_mem[reg + 7] & ESCREG_SMENABLE_BIT) == 0) &&
+      (sim_get16 (reg + 2) > 0);
+}
+
+/* Mirror SyncManager interrupts and pending events in the AL event register */
+static void sim_update_alevent (void)
+{
+   uint32_t event = sim_event;
+   uint8_t n;
+
+   for (n = 0; n < SIM_SM_COUNT; n++)
+   {
+      uint8_t status = esc_mem[SIM_SMREG (n) + 5];
+
+      if (sim_sm_enabled (n) &&
+          (status & (SIM_SM_STAT_INTW | SIM_SM_STAT_INTR)))
+      {
+         event |= (uint32_t)ESCREG_ALEVENT_SM0 << n;
+      }
+   }
+   esc_mem[ESCREG_ALEVENT] = (uint8_t)(event & 0xFF);
+   esc_mem[ESCREG_ALEVENT + 1] = (uint8_t)((event >> 8) & 0xFF);
+   esc_mem[ESCREG_ALEVENT + 2] = (uint8_t)((event >> 16) & 0xFF);
+   esc_mem[ESCREG_ALEVENT + 3] = (uint8_t)((event >> 24) & 0xFF);
+
+   /* Raise the IRQ on a rising edge of the masked events */
+   event &= (uint32_t)(esc_mem[ESCREG_ALEVENTMASK] |
+         (esc_mem[ESCREG_ALEVENTMASK + 1] << 8) |
+         (esc_mem[ESCREG_ALEVENTMASK + 2] << 16) |
+         ((uint32_t)esc_mem[ESCREG_ALEVENTMASK + 3] << 24));
+   if ((event != 0) && (sim_irq == 0) && (sim_irq_fd >= 0))
+   {
+      uint64_t value = 1;
+
+      if (write (sim_irq_fd, &value, sizeof (value)) != sizeof (value))
+      {
+         DPRINT ("Failed to signal sim IRQ\n");
+      }
+   }
+   sim_irq = (event != 0);
+}
+
+static void sim_sm_reset (uint8_t n)
+{
+   sim_sm[n].latest = -1;
+   sim_sm[n].wbuf = -1;
+   sim_sm[n].rbuf = -1;
+   esc_mem[SIM_SMREG (n) + 5] = SIM_SM_STAT_BUF (SIM_SM_BUF_NONE);
+}
+
+/* Register access byte by byte, applying the side effects of the ESC */
+static void sim_reg_read (int ecat, uint16_t address, uint8_t * value)
+{
+   *value = esc_mem[address];
+
+   if (ecat)
+   {
+      return;
+   }
+   /* PDI reading AL Control acknowledge the AL Control event */
+   if ((address & ~1U) == ESCREG_ALCONTROL)
+   {
+      sim_event &= ~(uint32_t)ESCREG_ALEVENT_CONTROL;
+   }
+   /* PDI reading SM activation acknowledge the SM change event */
+   else if ((address >= ESCREG_SM0) &&
+            (address < SIM_SMREG (SIM_SM_COUNT)) &&
+            ((address & 0x7) == 6))
+   {
+      sim_event &= ~(uint32_t)ESCREG_ALEVENT_SMCHANGE;
+   }
+}
+
+static void sim_reg_write (int ecat, uint16_t address, uint8_t value)
+{
+   uint8_t n;
+
+   /* AL event is read-only from both sides */
+   if ((address >= ESCREG_ALEVENT) && (address < ESCREG_ALEVENT + 4))
+   {
+      return;
+   }
+
+   if ((address >= ESCREG_SM0) && (address < SIM_SMREG (SIM_SM_COUNT)))
+   {
+      n = (uint8_t)((address - ESCREG_SM0) >> 3);
+      switch (address & 0x7)
+      {
+         case 5:
+            /* Status is read-only */
+            return;
+         case 6:
+            if (!ecat)
+            {
+               return;
+            }
+            esc_mem[address] = value;
+            sim_sm_reset (n);
+            sim_event |= ESCREG_ALEVENT_SMCHANGE;
+            return;
+         case 7:
+            if (ecat)
+            {
+               return;
+            }
+            esc_mem[address] = value;
+            if (value & ESCREG_SMENABLE_BIT)
+            {
+               sim_sm_reset (n);
+            }
+            return;
+         default:
+            if (!ecat)
+            {
+               return;
+            }
+            esc_mem[address] = value;
+            return;
+      }
+   }
+
+   if (ecat)
+   {
+      /* AL Status and AL Status Code are read-only for the master */
+      if ((address >= ESCREG_ALSTATUS) && (address < ESCREG_ALERROR + 2))
+      {
+         return;
+      }
+      esc_mem[address] = value;
+      if ((address & ~1U) == ESCREG_ALCONTROL)
+      {
+         sim_event |= ESCREG_ALEVENT_CONTROL;
+      }
+   }
+   else
+   {
+      /* AL Control and DL Status are read-only for the PDI */
+      if (((address & ~1U) == ESCREG_ALCONTROL) ||
+          ((address & ~1U) == ESCREG_DLSTATUS))
+      {
+         return;
+      }
+      esc_mem[address] = value;
+   }
+}
+
+/* Access to an enabled SyncManager area, offset relative to the start
+ * address. Returns 0 if the access is refused.
+ */
+static int sim_sm_access (int ecat, uint8_t n, uint16_t offset, uint8_t * buf,
+                          uint16_t len, int write)
+{
+   uint16_t reg = SIM_SMREG (n);
+   uint16_t psa = sim_get16 (reg);
+   uint16_t sml = sim_get16 (reg + 2);
+   uint8_t control = esc_mem[reg + 4];
+   uint8_t * status = &esc_mem[reg + 5];
+   sim_sm_t * sm = &sim_sm[n];
+   int ecat_writes = ((control & SIM_SM_DIR_MASK) == SIM_SM_DIR_ECAT_WRITE);
+   int writer = (ecat == ecat_writes);
+   int first = (offset == 0);
+   int last = ((offset + len) == sml);
+   uint32_t physical;
+   uint32_t buffers = ((control & SIM_SM_MODE_MASK) == SIM_SM_MODE_MBX) ? 1 : 3;
+
+   /* Refuse areas running past the end of the memory */
+   if (((uint32_t)psa + buffers * sml) > ESC_SIM_MEMSIZE)
+   {
+      return 0;
+   }
+
+   if ((control & SIM_SM_MODE_MASK) == SIM_SM_MODE_MBX)
+   {
+      physical = (uint32_t)psa + offset;
+      if (write)
+      {
+         if (!writer || (*status & SIM_SM_STAT_MBXFULL))
+         {
+            return 0;
+         }
+         memcpy (&esc_mem[physical], buf, len);
+         if (first && !ecat)
+         {
+            *status &= (uint8_t)~SIM_SM_STAT_INTR;
+         }
+         if (last)
+         {
+            *status |= SIM_SM_STAT_MBXFULL;
+            if (ecat)
+            {
+               *status |= SIM_SM_STAT_INTW;
+            }
+         }
+      }
+      else
+      {
+         if (writer || (ecat && ((*status & SIM_SM_STAT_MBXFULL) == 0)))
+         {
+            memcpy (buf, &esc_mem[physical], len);
+            return !ecat;
+         }
+         memcpy (buf, &esc_mem[physical], len);
+         if (first && !ecat)
+         {
+            *status &= (uint8_t)~SIM_SM_STAT_INTW;
+         }
+         if (last)
+         {
+            *status &= (uint8_t)~SIM_SM_STAT_MBXFULL;
+            if (ecat)
+            {
+               *status |= SIM_SM_STAT_INTR;
+            }
+         }
+      }
+      return 1;
+   }
+
+   /* 3-buffer mode, buffer k is located at start address + k * length */
+   if (write)
+   {
+      if (!writer)
+      {
+         return !ecat;
+      }
+      if (first || (sm->wbuf < 0))
+      {
+         /* Take the buffers in turn, skipping those in use */
+         int8_t k = (int8_t)((sm->latest + 1) % 3);
+         while ((k == sm->latest) || (k == sm->rbuf))
+         {
+            k = (int8_t)((k + 1) % 3);
+         }
+         sm->wbuf = k;
+      }
+      physical = (uint32_t)psa + (uint32_t)sm->wbuf * sml + offset;
+      memcpy (&esc_mem[physical], buf, len);
+      if (first && !ecat)
+      {
+         *status &= (uint8_t)~SIM_SM_STAT_INTR;
+      }
+      if (last)
+      {
+         sm->latest = sm->wbuf;
+         sm->wbuf = -1;
+         *status = (uint8_t)((*status & ~SIM_SM_STAT_BUF_MASK) |
+                             SIM_SM_STAT_BUF (sm->latest));
+         if (ecat)
+         {
+            *status |= SIM_SM_STAT_INTW;
+         }
+      }
+   }
+   else
+   {
+      int8_t k;
+
+      if (writer)
+      {
+         k = (sm->latest < 0) ? 0 : sm->latest;
+         physical = (uint32_t)psa + (uint32_t)k * sml + offset;
+         memcpy (buf, &esc_mem[physical], len);
+         return 1;
+      }
+      if (first || (sm->rbuf < 0))
+      {
+         sm->rbuf = (sm->latest < 0) ? 0 : sm->latest;
+      }
+      physical = (uint32_t)psa + (uint32_t)sm->rbuf * sml + offset;
+      memcpy (buf, &esc_mem[physical], len);
+      if (first && !ecat)
+      {
+         *status &= (uint8_t)~SIM_SM_STAT_INTW;
+      }
+      if (last)
+      {
+         sm->rbuf = -1;
+         if (ecat)
+         {
+            *status |= SIM_SM_STAT_INTR;
+         }
+      }
+   }
+   return 1;
+}
+
+static int sim_access (int ecat, uint16_t address, uint8_t * buf,
+                       uint16_t len, int write)
+{
+   int result = 1;
+
+   while (len > 0)
+   {
+      /* Accesses running past the end of the memory are cut there */
+      uint32_t end = MIN ((uint32_t)address + len, ESC_SIM_MEMSIZE);
+      uint16_t chunk;
+      uint8_t n;
+
+      /* Find an enabled SyncManager covering the address, or the start of
+       * the next one to limit the plain memory access.
+       */
+      for (n = 0; n < SIM_SM_COUNT; n++)
+      {
+         uint16_t reg = SIM_SMREG (n);
+         uint16_t psa = sim_get16 (reg);
+         uint16_t sml = sim_get16 (reg + 2);
+
+         if ((address < SIM_PRAM_START) || !sim_sm_enabled (n))
+         {
+            continue;
+         }
+         if ((address >= psa) && (address < psa + sml))
+         {
+            break;
+         }
+         if ((psa > address) && (psa < end))
+         {
+            end = psa;
+         }
+      }
+
+      if (n < SIM_SM_COUNT)
+      {
+         uint16_t reg = SIM_SMREG (n);
+         uint16_t psa = sim_get16 (reg);
+         uint16_t sml = sim_get16 (reg + 2);
+
+         chunk = (uint16_t)MIN ((uint32_t)len, (uint32_t)(psa + sml - address));
+         if (sim_sm_access (ecat, n, (uint16_t)(address - psa), buf, chunk,
+                            write) == 0)
+         {
+            result = 0;
+         }
+      }
+      else if (address < SIM_PRAM_START)
+      {
+         uint16_t i;
+
+         chunk = (uint16_t)(MIN (end, SIM_PRAM_START) - address);
+         for (i = 0; i < chunk; i++)
+         {
+            if (write)
+            {
+               sim_reg_write (ecat, (uint16_t)(address + i), buf[i]);
+            }
+            else
+            {
+               sim_reg_read (ecat, (uint16_t)(address + i), &buf[i]);
+            }
+         }
+      }
+      else
+      {
+         chunk = (uint16_t)(end - address);
+         if (write)
+         {
+            memcpy (&esc_mem[address], buf, chunk);
+         }
+         else
+         {
+            memcpy (buf, &esc_mem[address], chunk);
+         }
+      }
+
+      buf += chunk;
+      len = (uint16_t)(len - chunk);
+      address = (uint16_t)(address + chunk);
+      if ((address == 0) && (len > 0))
+      {
+         /* Wrapped around the address space */
+         result = 0;
+         break;
+      }
+   }
+
+   sim_update_alevent ();
+   return result;
+}
+
+int ESC_sim_ecat_read (uint16_t address, void * buf, uint16_t len)
+{
+   int result;
+
+   pthread_mutex_lock (&sim_lock);
+   result = sim_access (1, address, buf, len, 0);
+   pthread_mutex_unlock (&sim_lock);
+   return result;
+}
+
+int ESC_sim_ecat_write (uint16_t address, const void * buf, uint16_t len)
+{
+   int result;
+
+   pthread_mutex_lock (&sim_lock);
+   result = sim_access (1, address, (uint8_t *)buf, len, 1);
+   pthread_mutex_unlock (&sim_lock);
+   return result;
+}
+
+int ESC_sim_irq_fd (void)
+{
+   pthread_mutex_lock (&sim_lock);
+   if (sim_irq_fd < 0)
+   {
+      sim_irq_fd = eventfd (0, EFD_CLOEXEC);
+      sim_irq = 0;
+   }
+   pthread_mutex_unlock (&sim_lock);
+   return sim_irq_fd;
+}
+
+void ESC_sim_reset (void)
+{
+   uint8_t n;
+
+   pthread_mutex_lock (&sim_lock);
+   memset (esc_mem, 0, sizeof (esc_mem));
+   sim_event = 0;
+   for (n = 0; n < SIM_SM_COUNT; n++)
+   {
+      sim_sm_reset (n);
+   }
+   sim_set16 (ESCREG_DLSTATUS, SIM_DLSTATUS_PDI_OP);
+   sim_set16 (ESCREG_ALSTATUS, ESCinit);
+   sim_irq = 0;
+   sim_update_alevent ();
+   pthread_mutex_unlock (&sim_lock);
+}
+
+/** ESC read function used by the Slave stack.
+ *
+ * @param[in]   address     = address of ESC register to read
+ * @param[out]  buf         = pointer to buffer to read in
+ * @param[in]   len         = number of bytes to read
+ */
+void ESC_read (uint16_t address, void *buf, uint16_t len)
+{
+   pthread_mutex_lock (&sim_lock);
+   sim_access (0, address, buf, len, 0);
+   /* To mimic the ET1100 always providing AlEvent on every read or write */
+   ESCvar.ALevent = sim_alevent ();
+   pthread_mutex_unlock (&sim_lock);
+}
+
+/** ESC write function used by the Slave stack.
+ *
+ * @param[in]   address     = address of ESC register to write
+ * @param[out]  buf         = pointer to buffer to write from
+ * @param[in]   len         = number of bytes to write
+ */
+void ESC_write (uint16_t address, void *buf, uint16_t len)
+{
+   pthread_mutex_lock (&sim_lock);
+   sim_access (0, address, buf, len, 1);
+   /* To mimic the ET1100 always providing AlEvent on every read or write */
+   ESCvar.ALevent = sim_alevent ();
+   pthread_mutex_unlock (&sim_lock);
+}
+
+void ESC_reset (void)
+{
+   ESC_sim_reset ();
+}
+
+void ESC_init (const esc_cfg_t * config)
+{
+   ESC_sim_reset ();
+
+   /* Set AL event mask */
+   ESC_ALeventmaskwrite (ESCREG_ALEVENT_CONTROL |
+                         ESCREG_ALEVENT_SMCHANGE |
+                         ESCREG_ALEVENT_SM0 |
+                         ESCREG_ALEVENT_SM1);
+}
+
+void ESC_interrupt_enable (uint32_t mask)
+{
+   /* Enable interrupt for SYNC0 or SM2 or SM3 */
+   uint32_t user_int_mask = ESCREG_ALEVENT_DC_SYNC0 |
+                            ESCREG_ALEVENT_SM2 |
+                            ESCREG_ALEVENT_SM3;
+
+   if (mask & user_int_mask)
+   {
+      ESC_ALeventmaskwrite (ESC_ALeventmaskread () | (mask & user_int_mask));
+   }
+}
+
+void ESC_interrupt_disable (uint32_t mask)
+{
+   uint32_t user_int_mask = ESCREG_ALEVENT_DC_SYNC0 |
+                            ESCREG_ALEVENT_SM2 |
+                            ESCREG_ALEVENT_SM3;
+
+   if (mask & user_int_mask)
+   {
+      ESC_ALeventmaskwrite (ESC_ALeventmaskread () & ~(mask & user_int_mask));
+   }
+}
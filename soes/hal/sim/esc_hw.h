@@ -0,0 +1,58 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+ /** \file
+ * \brief
+ * In-memory ESC simulator, EtherCAT master side access functions.
+ */
+
+#ifndef __esc_hw__
+#define __esc_hw__
+
+#include <cc.h>
+
+/** Size of the simulated ESC address space, registers and process data RAM */
+#define ESC_SIM_MEMSIZE          0x10000
+
+/** Reset the simulated ESC to power-on state, all SyncManagers disabled and
+ * DL status reporting the PDI as operational.
+ */
+void ESC_sim_reset (void);
+
+/** Read from the simulated ESC as the EtherCAT master would do. SyncManager
+ * buffer semantics are applied to accesses inside an enabled SyncManager.
+ *
+ * @param[in]   address     = ESC address to read
+ * @param[out]  buf         = pointer to buffer to read in
+ * @param[in]   len         = number of bytes to read
+ * @return 1 if the access was accepted, 0 if it was refused by a
+ * SyncManager, e.g. reading an empty mailbox.
+ */
+int ESC_sim_ecat_read (uint16_t address, void * buf, uint16_t len);
+
+/** Write to the simulated ESC as the EtherCAT master would do. Writes to
+ * AL Control and SyncManager activation registers raise the corresponding
+ * AL events.
+ *
+ * @param[in]   address     = ESC address to write
+ * @param[in]   buf         = pointer to buffer to write from
+ * @param[in]   len         = number of bytes to write
+ * @return 1 if the access was accepted, 0 if it was refused by a
+ * SyncManager, e.g. writing a full mailbox.
+ */
+int ESC_sim_ecat_write (uint16_t address, const void * buf, uint16_t len);
+
+/** Get the eventfd emulating the ESC IRQ output. It is signalled when an
+ * AL event enabled in the AL event mask becomes pending, like an edge
+ * triggered IRQ line. Created on first call.
+ *
+ * @return eventfd, or -1 if it could not be created.
+ */
+int ESC_sim_irq_fd (void);
+
+void ESC_interrupt_enable (uint32_t mask);
+void ESC_interrupt_disable (uint32_t mask);
+
+#endif
@@ -14,6 +14,12 @@
 #define USE_FOE          1
 #endif
 
+/* Compute a CRC32 of FoE file downloads while they are received, see
+   crc32 of foe_file_cfg_t */
+#ifndef USE_FOE_CRC32
+#define USE_FOE_CRC32    0
+#endif
+
 /* EoE support */
 #ifndef USE_EOE
 #define USE_EOE          1
@@ -27,12 +33,21 @@
 #define MBXSIZEBOOT      128
 #endif
 
-#ifndef MBXBUFFERS
-#define MBXBUFFERS       3
+/* Smallest mailbox sizes accepted when configured by the master, MBXSIZE
+ * and MBXSIZEBOOT are the largest. The MBX buffers are always allocated
+ * for the largest size, only their stride in MBX follows the mailbox
+ * length configured by the master, so smaller mailboxes save no memory.
+ */
+#ifndef MIN_MBXSIZE
+#define MIN_MBXSIZE      MBXSIZE
+#endif
+
+#ifndef MIN_MBXSIZEBOOT
+#define MIN_MBXSIZEBOOT  MBXSIZEBOOT
 #endif
 
-#ifndef PREALLOC_FACTOR
-#define PREALLOC_FACTOR  3
+#ifndef MBXBUFFERS
+#define MBXBUFFERS       3
 #endif
 
 #ifndef MBX0_sma
@@ -147,5 +162,58 @@
 #define MAX_TXPDO_SIZE   128
 #endif
 
+/* Read and write process data directly from/to the mapped objects,
+   bypassing the pack/unpack pass, when the PDO mapping is the exact
+   memory layout of the mapped objects. Only used if
+   MAX_MAPPINGS_SM2/MAX_MAPPINGS_SM3 is non-zero. */
+#ifndef USE_ZEROCOPY_PDO
+#define USE_ZEROCOPY_PDO 0
+#endif
+
+/* Skip the Sync Manager 3 writes of unchanged inputs, writing only the
+   32-bit words differing from the SM3 buffers the ESC may write into.
+   Keeps an image of each of the three buffers, 3 * MAX_TXPDO_SIZE bytes.
+   Only used if MAX_MAPPINGS_SM3 is non-zero. */
+#ifndef USE_TXPDO_DIRTY
+#define USE_TXPDO_DIRTY  0
+#endif
+
+/* Max number of SM2 byte ranges read when the application consumes only
+   some of the mapped outputs, see the rxpdo_interest hook. Ranges are
+   merged over the smallest gaps to stay within the limit. 0 disables
+   partial reads. Only used if MAX_MAPPINGS_SM2 is non-zero. */
+#ifndef MAX_RXPDO_RANGES
+#define MAX_RXPDO_RANGES 0
+#endif
+
+/* Exchange the process data with the application through a lock-free
+   triple buffer instead of calling cb_set_outputs/cb_get_inputs from
+   DIG_process. DIG_process only copies SM2 to, and SM3 from, the latest
+   image, the application unpacks and packs the mapped objects in its
+   own context, see ecat_slv_read_outputs/ecat_slv_write_inputs. SM2 is
+   always read in full. Requires MAX_MAPPINGS_SM2 and MAX_MAPPINGS_SM3
+   to be non-zero, and can't be combined with USE_ZEROCOPY_PDO or
+   MAX_RXPDO_RANGES. USE_TXPDO_DIRTY still applies to the SM3 writes. */
+#ifndef USE_TRIPLE_BUFFER
+#define USE_TRIPLE_BUFFER 0
+#endif
+
+/* Latency and jitter instrumentation of the process data and mailbox
+   handling, see esc_stats.h. Requires the get_timestamp hook. */
+#ifndef USE_STATS
+#define USE_STATS        0
+#endif
+
+/* Number of records in the instrumentation ring buffer, power of two */
+#ifndef ESC_STATS_RING_SIZE
+#define ESC_STATS_RING_SIZE 256
+#endif
+
+/* Number of log2 latency histogram bins, the last bin counts all
+   larger latencies */
+#ifndef ESC_STATS_HIST_BINS
+#define ESC_STATS_HIST_BINS 32
+#endif
+
 
 #endif /* __options__ */
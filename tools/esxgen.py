@@ -0,0 +1,689 @@
+#!/usr/bin/env python3
+#
+# Licensed under the GNU General Public License version 2 with exceptions. See
+# LICENSE file in the project root for full license information
+#
+
+"""Generate the SOES object dictionary and SII EEPROM from an .esx file.
+
+The .esx slave description holds everything needed to build a slave: the
+object dictionary with the application variables it is bound to, the PDO
+mappings and the EEPROM settings. From it this script writes
+
+  <name>_objectlist.c   the const _objd/_objectlist tables
+  utypes.h              the _Objects storage and object positions
+  <name>.bin            the SII EEPROM image
+
+so none of them has to be maintained by hand.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import xml.etree.ElementTree as ET
+
+# Data type name: (DTYPE, bit length, C type)
+DATATYPES = {
+    'BOOLEAN': ('DTYPE_BOOLEAN', 1, 'uint8_t'),
+    'INTEGER8': ('DTYPE_INTEGER8', 8, 'int8_t'),
+    'INTEGER16': ('DTYPE_INTEGER16', 16, 'int16_t'),
+    'INTEGER32': ('DTYPE_INTEGER32', 32, 'int32_t'),
+    'INTEGER64': ('DTYPE_INTEGER64', 64, 'int64_t'),
+    'UNSIGNED8': ('DTYPE_UNSIGNED8', 8, 'uint8_t'),
+    'UNSIGNED16': ('DTYPE_UNSIGNED16', 16, 'uint16_t'),
+    'UNSIGNED32': ('DTYPE_UNSIGNED32', 32, 'uint32_t'),
+    'UNSIGNED64': ('DTYPE_UNSIGNED64', 64, 'uint64_t'),
+    'REAL32': ('DTYPE_REAL32', 32, 'float'),
+    'REAL64': ('DTYPE_REAL64', 64, 'double'),
+    'VISIBLE_STRING': ('DTYPE_VISIBLE_STRING', 8, 'char'),
+    'OCTET_STRING': ('DTYPE_OCTET_STRING', 8, 'uint8_t'),
+}
+for _n in range(1, 9):
+    DATATYPES['BIT%d' % _n] = ('DTYPE_BIT%d' % _n, _n, 'uint8_t')
+
+STRINGTYPES = ('VISIBLE_STRING', 'OCTET_STRING')
+
+BOOLEANS = {'false': '0', 'true': '1'}
+
+WRITE_RESTRICTIONS = {
+    'PreOP': 'ATYPE_RWpre',
+    'PreOP_SafeOP': 'ATYPE_RWpre_safe',
+    'OP': 'ATYPE_RWop',
+}
+
+# Version strings the application can override at build time
+VERSIONS = {0x1009: 'HW_REV', 0x100a: 'SW_REV'}
+
+# utypes.h sections, in order
+SECTIONS = [
+    ('identity', 'Identity'),
+    ('input', 'Inputs'),
+    ('output', 'Outputs'),
+    ('parameter', 'Parameters'),
+    ('manufacturer', 'Manufacturer specific data'),
+    ('txpdo', 'Dynamic TX PDO:s'),
+    ('rxpdo', 'Dynamic RX PDO:s'),
+    ('sm', 'Dynamic Sync Managers'),
+]
+
+# SII category types and codes, ETG.2010
+SII_STRINGS = 10
+SII_GENERAL = 30
+SII_FMMU = 40
+SII_SYNCM = 41
+SII_END = 0xffff
+FMMU_TYPES = {'Outputs': 1, 'Inputs': 2, 'MBoxState': 3}
+SM_TYPES = {'MBoxOut': 1, 'MBoxIn': 2, 'Outputs': 3, 'Inputs': 4}
+MBX_PROTOCOLS = {'EoE': 0x02, 'CoE': 0x04, 'FoE': 0x08, 'SoE': 0x10}
+COE_SDO = 0x01
+COE_PDOASSIGN = 0x04
+COE_PDOCONFIG = 0x08
+# Mailbox/CoE attributes, as in the ESI, and their CoE details bits
+COE_DETAILS = {
+    'SdoInfo': 0x02,
+    'PdoAssign': COE_PDOASSIGN,
+    'PdoConfig': COE_PDOCONFIG,
+    'PdoUpload': 0x10,
+    'CompleteAccess': 0x20,
+}
+SII_DEFAULT_BYTESIZE = 256
+
+
+class EsxError(Exception):
+    pass
+
+
+def parse_int(text):
+    text = text.strip()
+    if text.startswith('#x'):
+        return int(text[2:], 16)
+    return int(text, 0)
+
+
+def text(node, tag, default=None):
+    child = node.find(tag)
+    if child is None or child.text is None:
+        return default
+    return child.text.strip()
+
+
+class Entry(object):
+    """A subindex, or the single value of a VAR object."""
+
+    def __init__(self, node, obj):
+        self.obj = obj
+        self.subindex = parse_int(text(node, 'Index', '0'))
+        self.name = text(node, 'Name', '')
+        self.datatype = text(node, 'DataType')
+        if self.datatype not in DATATYPES:
+            raise EsxError('%04X:%02X: unsupported data type %s' %
+                           (obj.index, self.subindex, self.datatype))
+        self.default = text(node, 'DefaultValue')
+        self.access = text(node, 'Access', 'RO')
+        self.restriction = text(node, 'WriteRestriction')
+        self.pdomapping = text(node, 'PdoMapping', 'NONE')
+        self.variable = text(node, 'Variable')
+        self.vartype = text(node, 'VariableType')
+        self.length = text(node, 'Length')
+        self.member = None
+
+    @property
+    def dtype(self):
+        return DATATYPES[self.datatype][0]
+
+    @property
+    def ctype(self):
+        return DATATYPES[self.datatype][2]
+
+    @property
+    def is_string(self):
+        return self.datatype in STRINGTYPES
+
+    @property
+    def strlen(self):
+        if self.length is not None:
+            return parse_int(self.length)
+        return len(self.default or '')
+
+    @property
+    def bitlength(self):
+        if self.is_string:
+            return 8 * self.strlen
+        return DATATYPES[self.datatype][1]
+
+    @property
+    def flags(self):
+        if self.access == 'RW':
+            flags = WRITE_RESTRICTIONS.get(self.restriction, 'ATYPE_RW')
+        elif self.access == 'WO':
+            flags = 'ATYPE_WO'
+        else:
+            flags = 'ATYPE_RO'
+        if self.pdomapping in ('TX', 'TX_AND_RX'):
+            flags += ' | ATYPE_TXPDO'
+        if self.pdomapping in ('RX', 'TX_AND_RX'):
+            flags += ' | ATYPE_RXPDO'
+        return flags
+
+    @property
+    def value(self):
+        if self.is_string or self.default is None:
+            return '0'
+        return BOOLEANS.get(self.default.lower(), self.default)
+
+    @property
+    def intvalue(self):
+        if self.is_string or self.default is None:
+            return 0
+        return parse_int(self.value)
+
+
+class Object(object):
+    """An object of the dictionary."""
+
+    def __init__(self, node):
+        self.index = parse_int(text(node, 'Index'))
+        self.name = text(node, 'Name', '')
+        self.datatype = text(node, 'DataType')
+        self.variable = text(node, 'Variable')
+        self.vartype = text(node, 'VariableType')
+        if self.datatype in ('RECORD', 'ARRAY'):
+            self.otype = 'OTYPE_' + self.datatype
+            self.entries = [Entry(n, self) for n in node.findall('SubItem')]
+            self.entries.sort(key=lambda e: e.subindex)
+            if not self.entries:
+                raise EsxError('%04X: no subindexes' % self.index)
+        else:
+            self.otype = 'OTYPE_VAR'
+            self.entries = [Entry(node, self)]
+            self.entries[0].subindex = 0
+        self.maxsub = self.entries[-1].subindex if self.is_complex else 0
+
+    @property
+    def is_complex(self):
+        return self.otype != 'OTYPE_VAR'
+
+    @property
+    def section(self):
+        vartype = self.vartype
+        if vartype is None:
+            vartype = next((e.vartype for e in self.entries if e.vartype),
+                           None)
+        if vartype is not None:
+            return vartype.lower()
+        if 0x1600 <= self.index <= 0x17ff:
+            return 'rxpdo'
+        if 0x1a00 <= self.index <= 0x1bff:
+            return 'txpdo'
+        if 0x1c10 <= self.index <= 0x1c2f:
+            return 'sm'
+        if self.index == 0x1018:
+            return 'identity'
+        return 'manufacturer'
+
+    def entry(self, subindex):
+        for e in self.entries:
+            if e.subindex == subindex:
+                return e
+        return None
+
+
+class Slave(object):
+    """The parts of an .esx file the generator uses."""
+
+    def __init__(self, path):
+        try:
+            root = ET.parse(path).getroot()
+        except ET.ParseError as e:
+            raise EsxError('%s: %s' % (path, e))
+        if root.tag != 'Slave':
+            raise EsxError('%s: not an .esx file' % path)
+        self.root = root
+        self.id = root.get('id', '')
+        self.productcode = parse_int(root.get('productCode', '0'))
+        self.revision = parse_int(root.get('revisionNumber', '0'))
+        self.name = text(root, 'Name', self.id)
+        self.vendorid = parse_int(text(root, 'Vendor/Id', '0'))
+        self.grouptype = text(root, 'Group/Type', '')
+        self.objects = [Object(n) for n in root.findall('Dictionary/Item')]
+        self.objects.sort(key=lambda o: o.index)
+        indexes = [o.index for o in self.objects]
+        for i in range(1, len(indexes)):
+            if indexes[i] == indexes[i - 1]:
+                raise EsxError('%04X: duplicate object' % indexes[i])
+        self.bind_variables()
+        self.check_pdos()
+
+    def object(self, index):
+        for o in self.objects:
+            if o.index == index:
+                return o
+        return None
+
+    def bind_variables(self):
+        """Resolve the Obj member each entry is stored in. Subindexes of an
+        object that share a variable name are stored in an array."""
+        for o in self.objects:
+            counts = {}
+            for e in o.entries:
+                if e.variable is not None:
+                    counts[e.variable] = counts.get(e.variable, 0) + 1
+            seen = {}
+            for e in o.entries:
+                if e.variable is None or not o.is_complex:
+                    continue
+                member = e.variable
+                if counts[e.variable] > 1:
+                    member += '[%d]' % seen.get(e.variable, 0)
+                    seen[e.variable] = seen.get(e.variable, 0) + 1
+                e.member = (o.variable + '.' + member) if o.variable \
+                    else member
+            if not o.is_complex and o.variable is not None:
+                o.entries[0].member = o.variable
+            o.arrays = counts
+
+    def check_pdos(self):
+        """Check the default PDO mapping entries against the objects they
+        map, an entry is (index << 16) | (subindex << 8) | bitlength."""
+        for o in self.objects:
+            if not (0x1600 <= o.index <= 0x17ff or
+                    0x1a00 <= o.index <= 0x1bff):
+                continue
+            for e in o.entries[1:]:
+                mapping = e.intvalue
+                if mapping == 0:
+                    continue
+                index = mapping >> 16
+                subindex = (mapping >> 8) & 0xff
+                bitlength = mapping & 0xff
+                if index == 0:
+                    # padding
+                    continue
+                target = self.object(index)
+                mapped = target.entry(subindex) if target else None
+                if mapped is None:
+                    raise EsxError('%04X:%02X maps missing object %04X:%02X'
+                                   % (o.index, e.subindex, index, subindex))
+                if mapped.bitlength != bitlength:
+                    raise EsxError('%04X:%02X maps %d bits of %04X:%02X, '
+                                   'which has %d' %
+                                   (o.index, e.subindex, bitlength, index,
+                                    subindex, mapped.bitlength))
+
+    def storage(self):
+        """Objects stored in Obj, per utypes.h section."""
+        return [(title, [o for o in self.objects if o.section == section and
+                         any(e.member for e in o.entries)])
+                for section, title in SECTIONS]
+
+    def pdo_bits(self, assign):
+        """Size in bits of the PDOs in an assign object by default."""
+        o = self.object(assign)
+        if o is None:
+            return 0
+        bits = 0
+        npdos = o.entries[0].intvalue
+        for e in o.entries[1:npdos + 1]:
+            pdo = self.object(e.intvalue)
+            if pdo is None:
+                continue
+            nentries = pdo.entries[0].intvalue
+            for m in pdo.entries[1:nentries + 1]:
+                bits += m.intvalue & 0xff
+        return bits
+
+
+def define(name, value):
+    return '#define %-23s %d\n' % (name, value)
+
+
+def c_string(s):
+    return '"%s"' % s.replace('\\', '\\\\').replace('"', '\\"')
+
+
+def name_ref(o, e):
+    if o.is_complex:
+        return 'acName%04X_%02X' % (o.index, e.subindex)
+    return 'acName%04X' % o.index
+
+
+def data_ref(o, e):
+    if e.member is not None:
+        if e.is_string:
+            return 'Obj.' + e.member
+        return '&Obj.' + e.member
+    if e.is_string:
+        if o.index in VERSIONS:
+            return VERSIONS[o.index]
+        return c_string(e.default or '')
+    return 'NULL'
+
+
+def bitlength_ref(o, e):
+    if e.member is None and e.is_string and o.index in VERSIONS:
+        # The version string can be overridden at build time
+        return '8 * (sizeof (%s) - 1)' % VERSIONS[o.index]
+    return '%d' % e.bitlength
+
+
+def write_objectlist(slave, out):
+    w = out.write
+    w('#include "esc_coe.h"\n')
+    w('#include "utypes.h"\n')
+    w('#include <stddef.h>\n')
+    w('\n')
+    for index, macro in sorted(VERSIONS.items()):
+        o = slave.object(index)
+        if o is not None and o.entries[0].is_string:
+            w('#ifndef %s\n' % macro)
+            w('#define %s %s\n' % (macro, c_string(o.entries[0].default or '')))
+            w('#endif\n')
+            w('\n')
+
+    # Object and subindex names, each distinct name is stored once
+    names = {}
+    refs = {}
+
+    def add_name(ref, name):
+        if name not in names:
+            names[name] = ref
+            w('static const char %s[] = %s;\n' % (ref, c_string(name)))
+        refs[ref] = names[name]
+
+    for o in slave.objects:
+        add_name('acName%04X' % o.index, o.name)
+        if o.is_complex:
+            for e in o.entries:
+                add_name(name_ref(o, e), e.name)
+    w('\n')
+
+    for o in slave.objects:
+        w('const _objd SDO%04X[] =\n' % o.index)
+        w('{\n')
+        for e in o.entries:
+            w('  {%s, %s, %s, %s, %s, %s, %s},\n' %
+              ('0x%02X' % e.subindex if o.is_complex else '0x0',
+               e.dtype, bitlength_ref(o, e), e.flags, refs[name_ref(o, e)],
+               e.value, data_ref(o, e)))
+        w('};\n')
+    w('\n')
+
+    w('const _objectlist SDOobjects[] =\n')
+    w('{\n')
+    for o in slave.objects:
+        w('  {0x%04X, %s, %d, 0, %s, SDO%04X},\n' %
+          (o.index, o.otype, o.maxsub, refs['acName%04X' % o.index],
+           o.index))
+    w('  {0xffff, 0xff, 0xff, 0xff, NULL, NULL}\n')
+    w('};\n')
+    w('\n')
+    write_defaults(slave, out)
+
+
+def write_defaults(slave, out):
+    """Write ObjDefaults, the default values of Obj in its own layout, so
+    the stack can initialize all of Obj with a single copy."""
+    w = out.write
+
+    def value(e):
+        if e.is_string:
+            return c_string(e.default or '')
+        return e.value
+
+    def members(o, indent):
+        done = set()
+        for e in o.entries:
+            if e.variable is None or e.variable in done:
+                continue
+            done.add(e.variable)
+            if o.arrays[e.variable] > 1:
+                values = [value(m) for m in o.entries
+                          if m.variable == e.variable]
+                w('%s.%s =\n' % (indent, e.variable))
+                w('%s{\n' % indent)
+                for v in values:
+                    w('%s   %s,\n' % (indent, v))
+                w('%s},\n' % indent)
+            else:
+                w('%s.%s = %s,\n' % (indent, e.variable, value(e)))
+
+    w('const _Objects ObjDefaults =\n')
+    w('{\n')
+    for title, objects in slave.storage():
+        for o in objects:
+            if not o.is_complex:
+                w('   .%s = %s,\n' % (o.variable, value(o.entries[0])))
+            elif o.variable is not None:
+                w('   .%s =\n' % o.variable)
+                w('   {\n')
+                members(o, '      ')
+                w('   },\n')
+            else:
+                members(o, '   ')
+    w('};\n')
+
+
+def write_utypes(slave, out):
+    w = out.write
+    w('#ifndef __UTYPES_H__\n')
+    w('#define __UTYPES_H__\n')
+    w('\n')
+    w('#include "cc.h"\n')
+    w('\n')
+    w('/* Object dictionary storage */\n')
+    w('\n')
+    w('typedef struct\n')
+    w('{\n')
+
+    def member(e, name, indent):
+        if e.is_string:
+            w('%s%s %s[%d];\n' % (indent, e.ctype, name, e.strlen))
+        else:
+            w('%s%s %s;\n' % (indent, e.ctype, name))
+
+    def members(o, indent):
+        done = set()
+        for e in o.entries:
+            if e.variable is None or e.variable in done:
+                continue
+            done.add(e.variable)
+            if o.arrays[e.variable] > 1:
+                w('%s%s %s[%d];\n' % (indent, e.ctype, e.variable,
+                                      o.arrays[e.variable]))
+            else:
+                member(e, e.variable, indent)
+
+    for title, objects in slave.storage():
+        w('   /* %s */\n' % title)
+        w('\n')
+        for o in objects:
+            if not o.is_complex:
+                member(o.entries[0], o.variable, '   ')
+            elif o.variable is not None:
+                w('   struct\n')
+                w('   {\n')
+                members(o, '      ')
+                w('   } %s;\n' % o.variable)
+            else:
+                members(o, '   ')
+        if objects:
+            w('\n')
+
+    w('} _Objects;\n')
+    w('\n')
+    w('extern _Objects Obj;\n')
+    w('extern const _Objects ObjDefaults;\n')
+    w('\n')
+    w('/* Object positions in SDOobjects, usable instead of a lookup */\n')
+    w('\n')
+    for n, o in enumerate(slave.objects):
+        w(define('SDO_OBJ_%04X' % o.index, n))
+    w(define('SDO_OBJECTS', len(slave.objects)))
+    w('\n')
+    w('/* Process data sizes in bytes of the default PDO assignment */\n')
+    w('\n')
+    w(define('DEFAULT_RXPDO_SIZE', (slave.pdo_bits(0x1c12) + 7) // 8))
+    w(define('DEFAULT_TXPDO_SIZE', (slave.pdo_bits(0x1c13) + 7) // 8))
+    w('\n')
+    w('#endif /* __UTYPES_H__ */\n')
+
+
+def crc8(data):
+    """SII configuration area checksum, x^8 + x^2 + x + 1 initialized to
+    0xff."""
+    crc = 0xff
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xff if crc & 0x80 else crc << 1
+    return crc
+
+
+def hexbytes(s, size, what):
+    data = bytes.fromhex(s or '')
+    if len(data) != size:
+        raise EsxError('%s must be %d bytes' % (what, size))
+    return data
+
+
+def sii_category(cattype, data):
+    if len(data) % 2:
+        data += b'\0'
+    return struct.pack('<HH', cattype, len(data) // 2) + data
+
+
+def build_sii(slave):
+    root = slave.root
+    bytesize = parse_int(text(root, 'Eeprom/ByteSize',
+                              str(SII_DEFAULT_BYTESIZE)))
+    mbx = root.find('Mailbox')
+    sms = [(n.text.strip(), parse_int(n.get('StartAddress', '0')),
+            parse_int(n.get('DefaultSize', '0')),
+            parse_int(n.get('ControlByte', '0')))
+           for n in root.findall('Sm')]
+    protocols = 0
+    if mbx is not None:
+        for name, bit in MBX_PROTOCOLS.items():
+            if mbx.get(name) == 'true':
+                protocols |= bit
+
+    # Configuration area with checksum, identity and mailbox settings
+    sii = bytearray(hexbytes(text(root, 'Eeprom/ConfigData'), 8,
+                             'ConfigData'))
+    sii += bytes(6)
+    sii += struct.pack('<H', crc8(sii))
+    sii += struct.pack('<IIII', slave.vendorid, slave.productcode,
+                       slave.revision, 0)
+    sii += bytes(8)
+    sii += hexbytes(text(root, 'Eeprom/BootStrap', '00' * 8), 8, 'BootStrap')
+    mbxout = next((s for s in sms if s[0] == 'MBoxOut'), None)
+    mbxin = next((s for s in sms if s[0] == 'MBoxIn'), None)
+    if mbxout is not None and mbxin is not None:
+        sii += struct.pack('<HHHH', mbxout[1], mbxout[2], mbxin[1], mbxin[2])
+    else:
+        sii += bytes(8)
+    sii += struct.pack('<H', protocols)
+    sii += bytes(0x7c - len(sii))
+    sii += struct.pack('<HH', bytesize * 8 // 1024 - 1, 1)
+
+    # Strings, referenced by 1-based index from the General category
+    strings = []
+    for s in (slave.id, slave.grouptype, slave.name):
+        if s not in strings:
+            strings.append(s)
+    data = bytearray([len(strings)])
+    for s in strings:
+        raw = s.encode('ascii')
+        data += bytes([len(raw)]) + raw
+    sii += sii_category(SII_STRINGS, data)
+
+    coe = 0
+    if protocols & MBX_PROTOCOLS['CoE']:
+        coe = COE_SDO
+        details = mbx.find('CoE')
+        if details is not None:
+            for name, bit in COE_DETAILS.items():
+                if details.get(name) == 'true':
+                    coe |= bit
+        for node in root.findall('SmAssignment'):
+            if node.get('dynamic') == 'true':
+                coe |= COE_PDOASSIGN
+        for node in root.findall('RxPdo') + root.findall('TxPdo'):
+            if node.get('dynamic') == 'true':
+                coe |= COE_PDOCONFIG
+    general = bytearray(32)
+    general[0] = strings.index(slave.grouptype) + 1
+    general[2] = strings.index(slave.id) + 1
+    general[3] = strings.index(slave.name) + 1
+    # Reserved in ETG.2010, kept so existing images can be reproduced
+    general[4] = parse_int(text(root, 'Eeprom/GeneralReserved', '0'))
+    general[5] = coe
+    general[6] = 1 if protocols & MBX_PROTOCOLS['FoE'] else 0
+    general[7] = 1 if protocols & MBX_PROTOCOLS['EoE'] else 0
+    sii += sii_category(SII_GENERAL, general)
+
+    data = bytearray(FMMU_TYPES[n.text.strip()]
+                     for n in root.findall('Fmmu'))
+    sii += sii_category(SII_FMMU, data)
+
+    data = bytearray()
+    for name, start, size, control in sms:
+        if name not in ('MBoxOut', 'MBoxIn'):
+            size = 0
+        data += struct.pack('<HHBBBB', start, size, control, 0, 1,
+                            SM_TYPES[name])
+    sii += sii_category(SII_SYNCM, data)
+
+    sii += struct.pack('<H', SII_END)
+    if len(sii) > bytesize:
+        raise EsxError('SII needs %d bytes, EEPROM has %d' %
+                       (len(sii), bytesize))
+    sii += b'\xff' * (bytesize - len(sii))
+    return bytes(sii)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('esx', help='slave description (.esx)')
+    parser.add_argument('-o', '--outdir',
+                        help='output directory, default is the .esx '
+                        'directory')
+    parser.add_argument('--objectlist', help='object dictionary source')
+    parser.add_argument('--utypes', help='object storage header')
+    parser.add_argument('--sii', help='SII EEPROM image')
+    args = parser.parse_args(argv)
+
+    base = os.path.splitext(os.path.basename(args.esx))[0]
+    outdir = args.outdir or os.path.dirname(os.path.abspath(args.esx))
+    objectlist = args.objectlist or os.path.join(outdir,
+                                                 base + '_objectlist.c')
+    utypes = args.utypes or os.path.join(outdir, 'utypes.h')
+    sii = args.sii or os.path.join(outdir, base + '.bin')
+
+    try:
+        slave = Slave(args.esx)
+        image = build_sii(slave)
+    except EsxError as e:
+        sys.stderr.write('esxgen: %s\n' % e)
+        return 1
+
+    try:
+        for path in (objectlist, utypes, sii):
+            directory = os.path.dirname(os.path.abspath(path))
+            if not os.path.isdir(directory):
+                os.makedirs(directory)
+        with open(objectlist, 'w') as f:
+            write_objectlist(slave, f)
+        with open(utypes, 'w') as f:
+            write_utypes(slave, f)
+        with open(sii, 'wb') as f:
+            f.write(image)
+    except (IOError, OSError) as e:
+        sys.stderr.write('esxgen: %s\n' % e)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())